@@ -0,0 +1,121 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+// builds a dictionary of syllables sharing the prefix "q" so that a
+// predictive lookup for "q" yields one chunk per syllable.
+static Dictionary* PrepareDictionary(int num_syllables, int num_homophones) {
+  static map<int, the<Dictionary>> cache;
+  auto& dict = cache[num_syllables];
+  if (dict) {
+    return dict.get();
+  }
+  string name = "dictionary_bench_" + std::to_string(num_syllables);
+  auto table = New<Table>(path{name + ".table.bin"});
+  auto prism = New<Prism>(path{name + ".prism.bin"});
+  Syllabary syllabary;
+  Vocabulary vocabulary;
+  size_t num_entries = 0;
+  for (int i = 0; i < num_syllables; ++i) {
+    string syllable{'q', char('a' + i / 26), char('a' + i % 26)};
+    syllabary.insert(syllable);
+    for (int j = 0; j < num_homophones; ++j) {
+      auto e = New<ShortDictEntry>();
+      e->code.push_back(i);
+      e->text = syllable + std::to_string(j);
+      // interleave weights across syllables
+      e->weight = double((j * num_syllables + i * 7) % 1000);
+      vocabulary[i].entries.push_back(e);
+      ++num_entries;
+    }
+  }
+  vocabulary.SortHomophones();
+  table->Remove();
+  prism->Remove();
+  if (!table->Build(syllabary, vocabulary, num_entries) || !table->Save() ||
+      !prism->Build(syllabary) || !prism->Save()) {
+    return nullptr;
+  }
+  dict.reset(new Dictionary(name, {}, {table}, prism));
+  dict->Load();
+  return dict.get();
+}
+
+static void BM_DictEntryIteratorNext(benchmark::State& state) {
+  const int num_syllables = state.range(0);
+  const int num_homophones = 16;
+  Dictionary* dict = PrepareDictionary(num_syllables, num_homophones);
+  if (!dict || !dict->loaded()) {
+    state.SkipWithError("failed to prepare dictionary.");
+    return;
+  }
+  size_t num_entries = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    DictEntryIterator iter;
+    dict->LookupWords(&iter, "q", true);
+    state.ResumeTiming();
+    do {
+      benchmark::DoNotOptimize(iter.Peek());
+      ++num_entries;
+    } while (iter.Next());
+  }
+  state.SetItemsProcessed(num_entries);
+}
+BENCHMARK(BM_DictEntryIteratorNext)->RangeMultiplier(4)->Range(8, 512);
+
+static void BM_DictEntryIteratorFiltered(benchmark::State& state) {
+  const int num_syllables = state.range(0);
+  const int num_homophones = 16;
+  Dictionary* dict = PrepareDictionary(num_syllables, num_homophones);
+  if (!dict || !dict->loaded()) {
+    state.SkipWithError("failed to prepare dictionary.");
+    return;
+  }
+  size_t num_entries = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    DictEntryIterator iter;
+    dict->LookupWords(&iter, "q", true);
+    state.ResumeTiming();
+    // rejects most of the entries, as a charset filter or blacklist would
+    iter.AddFilter([](const DictEntryView& entry) {
+      return !entry.text.empty() && entry.text.back() == '0';
+    });
+    while (!iter.exhausted()) {
+      benchmark::DoNotOptimize(iter.Peek());
+      ++num_entries;
+      iter.Next();
+    }
+  }
+  state.SetItemsProcessed(num_entries);
+}
+BENCHMARK(BM_DictEntryIteratorFiltered)->RangeMultiplier(4)->Range(8, 512);
+
+// looks up words at every syllable boundary, as when making a sentence.
+static void BM_DictionaryLookup(benchmark::State& state) {
+  Dictionary* dict = LunaPinyinDictionary();
+  SyllableGraph graph;
+  const string input = string(kLunaPinyinInput).substr(0, state.range(0));
+  if (!dict || !SyllabifyLunaPinyin(input, &graph)) {
+    state.SkipWithError("failed to prepare luna_pinyin.");
+    return;
+  }
+  size_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const auto& x : graph.edges) {
+      benchmark::DoNotOptimize(dict->Lookup(graph, x.first));
+      ++num_lookups;
+    }
+  }
+  state.SetItemsProcessed(num_lookups);
+}
+BENCHMARK(BM_DictionaryLookup)->RangeMultiplier(4)->Range(4, 64);
@@ -0,0 +1,43 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime_api.h>
+#include <rime/common.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+// latency of a keystroke on luna_pinyin, typing up to state.range(0) letters
+// before the composition is cleared.  each round starts at a different
+// offset of the sentence, so that translations are not simply reused.
+static void BM_RimeProcessKey(benchmark::State& state) {
+  if (!PrepareLunaPinyin()) {
+    state.SkipWithError("failed to deploy luna_pinyin.");
+    return;
+  }
+  RimeApi* rime = rime_get_api();
+  RimeSessionId session_id = rime->create_session();
+  if (!session_id || !rime->select_schema(session_id, "luna_pinyin")) {
+    state.SkipWithError("failed to create session.");
+    return;
+  }
+  const string sentence = string(kLunaPinyinInput) + kLunaPinyinInput;
+  const size_t length = state.range(0);
+  size_t offset = 0;
+  size_t pos = 0;
+  for (auto _ : state) {
+    if (pos == length) {
+      state.PauseTiming();
+      rime->clear_composition(session_id);
+      offset = (offset + 7) % (sentence.length() / 2);
+      pos = 0;
+      state.ResumeTiming();
+    }
+    rime->process_key(session_id, sentence[offset + pos++], 0);
+  }
+  state.SetItemsProcessed(state.iterations());
+  rime->destroy_session(session_id);
+}
+BENCHMARK(BM_RimeProcessKey)->RangeMultiplier(4)->Range(4, 64);
@@ -0,0 +1,74 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <rime_api.h>
+#include <rime/deployer.h>
+#include <rime/schema.h>
+#include <rime/service.h>
+#include <rime/ticket.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include "luna_pinyin.h"
+
+namespace rime {
+
+const char* kLunaPinyinInput =
+    "zhonghuarenmingongheguozaiershishijimowanchengleshehuizhuyi"
+    "xiandaihuajianshedediyibuzhanluemubiaoxianzaizhengzaixiang";
+
+Schema* PrepareLunaPinyin() {
+  static the<Schema> schema;
+  if (schema) {
+    return schema.get();
+  }
+  RimeApi* rime = rime_get_api();
+  RIME_STRUCT(RimeTraits, traits);
+  // data files are copied to the working directory ($build/bench).
+  traits.shared_data_dir = traits.user_data_dir = ".";
+  traits.app_name = "rime.bench";
+  rime->setup(&traits);
+  rime->initialize(&traits);
+  // returns false if there is nothing to update
+  if (rime->start_maintenance(False)) {
+    rime->join_maintenance_thread();
+  }
+  schema.reset(new Schema("luna_pinyin"));
+  if (!schema->config()) {
+    schema.reset();
+  }
+  return schema.get();
+}
+
+path StagingFile(const string& file_name) {
+  return Service::instance().deployer().staging_dir / file_name;
+}
+
+Dictionary* LunaPinyinDictionary() {
+  static the<Dictionary> dict;
+  if (dict) {
+    return dict.get();
+  }
+  Schema* schema = PrepareLunaPinyin();
+  if (!schema) {
+    return nullptr;
+  }
+  if (auto c = Dictionary::Require("dictionary")) {
+    dict.reset(c->Create(Ticket(schema, "translator")));
+  }
+  if (dict && !dict->Load()) {
+    dict.reset();
+  }
+  return dict.get();
+}
+
+bool SyllabifyLunaPinyin(const string& input, SyllableGraph* graph) {
+  Dictionary* dict = LunaPinyinDictionary();
+  if (!dict) {
+    return false;
+  }
+  Syllabifier syllabifier(" '", true);
+  return syllabifier.BuildSyllableGraph(input, *dict->prism(), graph) > 0;
+}
+
+}  // namespace rime
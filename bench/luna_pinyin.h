@@ -0,0 +1,34 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#ifndef RIME_BENCH_LUNA_PINYIN_H_
+#define RIME_BENCH_LUNA_PINYIN_H_
+
+#include <rime/common.h>
+
+namespace rime {
+
+class Dictionary;
+class Schema;
+struct SyllableGraph;
+
+// a long sentence typed in pinyin, to be cut to the desired length.
+extern const char* kLunaPinyinInput;
+
+// initializes rime in the working directory and deploys the bundled
+// luna_pinyin schema, unless up to date; returns the loaded schema.
+Schema* PrepareLunaPinyin();
+
+// path to a compiled file in the staging directory.
+path StagingFile(const string& file_name);
+
+// the translator's dictionary, loaded once.
+Dictionary* LunaPinyinDictionary();
+
+// syllabifies input with the translator's settings.
+bool SyllabifyLunaPinyin(const string& input, SyllableGraph* graph);
+
+}  // namespace rime
+
+#endif  // RIME_BENCH_LUNA_PINYIN_H_
@@ -0,0 +1,86 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include "luna_pinyin.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace rime;
+
+// drops the cached pages of a file, so that the next access reads the disk.
+static bool EvictFromPageCache(const path& file_path) {
+#ifdef POSIX_FADV_DONTNEED
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+static const struct {
+  const char* label;
+  MappedFileLoadPolicy policy;
+} kLoadPolicies[] = {
+    {"default", {}},
+    {"random_access", {false, true}},
+    {"prefetch", {true, true}},
+    {"populate", {false, false, true}},
+    {"huge_pages", {true, false, false, false, true}},
+};
+
+// loads the luna_pinyin dictionary and looks up the first syllable, as
+// the first keystroke after switching to the schema does.
+static void BM_FirstKeystroke(benchmark::State& state) {
+  const bool cold = state.range(0);
+  const auto& load_policy = kLoadPolicies[state.range(1)];
+  state.SetLabel(string(cold ? "cold/" : "warm/") + load_policy.label);
+  if (!PrepareLunaPinyin()) {
+    state.SkipWithError("failed to prepare luna_pinyin.");
+    return;
+  }
+  const path table_file = StagingFile("luna_pinyin.table.bin");
+  const path prism_file = StagingFile("luna_pinyin.prism.bin");
+  Syllabifier syllabifier(" '", true);
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (cold &&
+        (!EvictFromPageCache(table_file) || !EvictFromPageCache(prism_file))) {
+      state.SkipWithError("failed to evict files from page cache.");
+      break;
+    }
+    auto table = New<Table>(table_file);
+    auto prism = New<Prism>(prism_file);
+    table->set_load_policy(load_policy.policy);
+    prism->set_load_policy(load_policy.policy);
+    Dictionary dict("luna_pinyin", {}, {table}, prism);
+    state.ResumeTiming();
+    SyllableGraph graph;
+    if (!dict.Load() ||
+        !syllabifier.BuildSyllableGraph("zhong", *prism, &graph)) {
+      state.SkipWithError("failed to load luna_pinyin.");
+      break;
+    }
+    benchmark::DoNotOptimize(dict.Lookup(graph, 0));
+    state.PauseTiming();
+    // unmapping is not part of the keystroke
+    dict.primary_table()->Close();
+    prism->Close();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_FirstKeystroke)
+    ->ArgsProduct({{1, 0}, {0, 1, 2, 3, 4}})
+    ->Unit(benchmark::kMicrosecond);
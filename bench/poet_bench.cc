@@ -0,0 +1,63 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/language.h>
+#include <rime/schema.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include <rime/gear/poet.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+// collects words into a graph as script_translator does, keeping the best
+// few homophones of each span.
+static bool PrepareWordGraph(const string& input,
+                             size_t max_homophones,
+                             WordGraph* graph,
+                             size_t* total_length) {
+  Dictionary* dict = LunaPinyinDictionary();
+  SyllableGraph syllable_graph;
+  if (!dict || !SyllabifyLunaPinyin(input, &syllable_graph)) {
+    return false;
+  }
+  for (const auto& x : syllable_graph.edges) {
+    auto& same_start_pos = (*graph)[x.first];
+    auto collector = dict->Lookup(syllable_graph, x.first);
+    if (!collector)
+      continue;
+    for (auto& y : *collector) {
+      DictEntryList& homophones = same_start_pos[y.first];
+      while (homophones.size() < max_homophones && !y.second.exhausted()) {
+        homophones.push_back(y.second.Peek());
+        if (!y.second.Next())
+          break;
+      }
+    }
+  }
+  *total_length = syllable_graph.interpreted_length;
+  return true;
+}
+
+static void BM_PoetMakeSentence(benchmark::State& state) {
+  Schema* schema = PrepareLunaPinyin();
+  const string input = string(kLunaPinyinInput).substr(0, state.range(0));
+  WordGraph graph;
+  size_t total_length = 0;
+  if (!schema ||
+      !PrepareWordGraph(input, state.range(1), &graph, &total_length)) {
+    state.SkipWithError("failed to prepare word graph.");
+    return;
+  }
+  Language language("luna_pinyin");
+  Poet poet(&language, schema->config());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(poet.MakeSentence(graph, total_length, ""));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PoetMakeSentence)
+    ->ArgsProduct({benchmark::CreateRange(4, 64, 4), {1, 4}});
@@ -0,0 +1,70 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/dict/prism.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+static Prism* LoadPrism() {
+  static the<Prism> prism;
+  if (prism) {
+    return prism.get();
+  }
+  if (!PrepareLunaPinyin()) {
+    return nullptr;
+  }
+  prism.reset(new Prism(StagingFile("luna_pinyin.prism.bin")));
+  if (!prism->Load()) {
+    prism.reset();
+  }
+  return prism.get();
+}
+
+// searches spellings at every position of the input, as the syllabifier does.
+static void BM_PrismCommonPrefixSearch(benchmark::State& state) {
+  Prism* prism = LoadPrism();
+  if (!prism) {
+    state.SkipWithError("failed to load prism.");
+    return;
+  }
+  const string input = string(kLunaPinyinInput).substr(0, state.range(0));
+  vector<Prism::Match> matches;
+  size_t num_searches = 0;
+  for (auto _ : state) {
+    for (size_t pos = 0; pos < input.length(); ++pos) {
+      matches.clear();
+      prism->CommonPrefixSearch(input.substr(pos), &matches);
+      benchmark::DoNotOptimize(matches.data());
+      ++num_searches;
+    }
+  }
+  state.SetItemsProcessed(num_searches);
+}
+BENCHMARK(BM_PrismCommonPrefixSearch)->RangeMultiplier(4)->Range(4, 64);
+
+// completes a partial spelling, as at the end of input.
+static void BM_PrismExpandSearch(benchmark::State& state) {
+  Prism* prism = LoadPrism();
+  if (!prism) {
+    state.SkipWithError("failed to load prism.");
+    return;
+  }
+  const string prefixes[] = {"z", "zh", "zho", "x", "xi", "xia", "xian"};
+  const size_t limit = state.range(0);
+  vector<Prism::Match> matches;
+  size_t num_searches = 0;
+  for (auto _ : state) {
+    for (const string& prefix : prefixes) {
+      matches.clear();
+      prism->ExpandSearch(prefix, &matches, limit);
+      benchmark::DoNotOptimize(matches.data());
+      ++num_searches;
+    }
+  }
+  state.SetItemsProcessed(num_searches);
+}
+BENCHMARK(BM_PrismExpandSearch)->Arg(0)->Arg(10);
@@ -0,0 +1,104 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <utf8.h>
+#include <rime/common.h>
+#include <rime/algo/strings.h>
+
+using namespace rime;
+
+// a candidate text of the given length in code points, mostly CJK.
+static string MakeText(int length) {
+  static const char* kChars[] = {"中", "華", "人", "民", "a", "共", "和", "國"};
+  string text;
+  for (int i = 0; i < length; ++i) {
+    text += kChars[i % 8];
+  }
+  return text;
+}
+
+static void BM_Utf8DistanceUnchecked(benchmark::State& state) {
+  const string text = MakeText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        utf8::unchecked::distance(text.c_str(), text.c_str() + text.length()));
+  }
+  state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Utf8DistanceUnchecked)->RangeMultiplier(4)->Range(1, 256);
+
+static void BM_Utf8Length(benchmark::State& state) {
+  const string text = MakeText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strings::utf8_length(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Utf8Length)->RangeMultiplier(4)->Range(1, 256);
+
+static void BM_Utf8IsValid(benchmark::State& state) {
+  const string text = MakeText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utf8::is_valid(text.begin(), text.end()));
+  }
+  state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Utf8IsValid)->RangeMultiplier(4)->Range(1, 256);
+
+static void BM_Utf8Valid(benchmark::State& state) {
+  const string text = MakeText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strings::utf8_valid(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Utf8Valid)->RangeMultiplier(4)->Range(1, 256);
+
+static void BM_Utf8ValidAscii(benchmark::State& state) {
+  const string text(state.range(0), 'a');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strings::utf8_valid(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.length());
+}
+BENCHMARK(BM_Utf8ValidAscii)->RangeMultiplier(4)->Range(1, 256);
+
+// a line of a dict.yaml file, split into columns while compiling.
+static const char* kDictLine = "中華人民共和國\tzhong hua ren min gong he guo\t100";
+
+static void BM_SplitFindFirstOf(benchmark::State& state) {
+  const string line = kDictLine;
+  const string delim = "\t";
+  for (auto _ : state) {
+    vector<string> row;
+    size_t last = 0;
+    size_t pos = line.find_first_of(delim);
+    while (pos != string::npos) {
+      row.push_back(line.substr(last, pos - last));
+      last = pos + 1;
+      pos = line.find_first_of(delim, last);
+    }
+    row.push_back(line.substr(last));
+    benchmark::DoNotOptimize(row);
+  }
+}
+BENCHMARK(BM_SplitFindFirstOf);
+
+static void BM_Split(benchmark::State& state) {
+  const string line = kDictLine;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strings::split(line, "\t"));
+  }
+}
+BENCHMARK(BM_Split);
+
+static void BM_SplitSkipToken(benchmark::State& state) {
+  const string code = "zhong  hua ren min gong he guo";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        strings::split(code, " ", strings::SplitBehavior::SkipToken));
+  }
+}
+BENCHMARK(BM_SplitSkipToken);
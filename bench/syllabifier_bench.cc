@@ -0,0 +1,133 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/config.h>
+#include <rime/algo/algebra.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/prism.h>
+
+using namespace rime;
+
+static const char* kInitials[] = {
+    "",  "b", "p", "m", "f", "d", "t", "n", "l", "g",  "k",  "h",
+    "j", "q", "x", "r", "z", "c", "s", "y", "w", "zh", "ch", "sh",
+};
+
+static const char* kFinals[] = {
+    "a",   "o",   "e",    "i",   "u",  "v",    "ai",   "ei",  "ao",
+    "ou",  "an",  "en",   "ang", "eng", "ong", "er",   "ia",  "ie",
+    "iao", "iu",  "ian",  "in",  "iang", "ing", "iong", "ua", "uo",
+    "uai", "ui",  "uan",  "un",  "uang", "ue",
+};
+
+// fuzzy spellings and abbreviations make the graph highly ambiguous
+static const char* kAlgebra[] = {
+    "derive/^([zcs])h/$1/",         "derive/^([zcs])([^h])/$1h$2/",
+    "derive/([ei])n$/$1ng/",        "derive/([ei])ng$/$1n/",
+    "abbrev/^([a-z]).+$/$1/",       "abbrev/^([zcs]h).+$/$1/",
+};
+
+static const char* kSentence =
+    "zhonghuarenmingongheguozaiershishijimowanchengleshehuizhuyi"
+    "xiandaihuajianshedediyibuzhanluemubiaoxianzaizhengzaixiang";
+
+static Prism* PreparePrism() {
+  static the<Prism> prism;
+  if (prism) {
+    return prism.get();
+  }
+  Syllabary syllabary;
+  for (const char* initial : kInitials) {
+    for (const char* final : kFinals) {
+      syllabary.insert(string(initial) + final);
+    }
+  }
+  Script script;
+  for (const auto& syllable : syllabary) {
+    script.AddSyllable(syllable);
+  }
+  auto algebra = New<ConfigList>();
+  for (const char* formula : kAlgebra) {
+    algebra->Append(New<ConfigValue>(formula));
+  }
+  Projection projection;
+  if (!projection.Load(algebra) || !projection.Apply(&script)) {
+    return nullptr;
+  }
+  prism.reset(new Prism(path{"syllabifier_bench.prism.bin"}));
+  prism->Remove();
+  if (!prism->Build(syllabary, &script)) {
+    prism.reset();
+  }
+  return prism.get();
+}
+
+static void BM_BuildSyllableGraph(benchmark::State& state) {
+  Prism* prism = PreparePrism();
+  if (!prism) {
+    state.SkipWithError("failed to prepare prism.");
+    return;
+  }
+  const string input = string(kSentence).substr(0, state.range(0));
+  Syllabifier syllabifier("'", true);
+  for (auto _ : state) {
+    SyllableGraph graph;
+    benchmark::DoNotOptimize(
+        syllabifier.BuildSyllableGraph(input, *prism, &graph));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BuildSyllableGraph)->RangeMultiplier(2)->Range(8, 64);
+
+// alternates typing the last character and deleting it.
+static void BM_BuildSyllableGraphIncremental(benchmark::State& state) {
+  Prism* prism = PreparePrism();
+  if (!prism) {
+    state.SkipWithError("failed to prepare prism.");
+    return;
+  }
+  const string input = string(kSentence).substr(0, state.range(0));
+  const string inputs[] = {input, input.substr(0, input.length() - 1)};
+  SyllableGraphCache cache;
+  Syllabifier syllabifier("'", true);
+  syllabifier.EnableCache(&cache);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        syllabifier.BuildSyllableGraph(inputs[i++ % 2], *prism));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BuildSyllableGraphIncremental)->RangeMultiplier(2)->Range(8, 64);
+
+// visits every edge through the transposed index, as dictionary lookups do.
+static void BM_TraverseSyllableGraph(benchmark::State& state) {
+  Prism* prism = PreparePrism();
+  if (!prism) {
+    state.SkipWithError("failed to prepare prism.");
+    return;
+  }
+  const string input = string(kSentence).substr(0, state.range(0));
+  Syllabifier syllabifier("'", true);
+  SyllableGraph graph;
+  syllabifier.BuildSyllableGraph(input, *prism, &graph);
+  size_t num_edges = 0;
+  for (auto _ : state) {
+    for (size_t pos = 0; pos < graph.interpreted_length; ++pos) {
+      auto index = graph.indices.find(pos);
+      if (!index)
+        continue;
+      for (const auto& syllable : *index) {
+        for (const auto* props : syllable.spellings) {
+          benchmark::DoNotOptimize(props->end_pos);
+          ++num_edges;
+        }
+      }
+    }
+  }
+  state.SetItemsProcessed(num_edges);
+}
+BENCHMARK(BM_TraverseSyllableGraph)->RangeMultiplier(2)->Range(8, 64);
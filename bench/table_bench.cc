@@ -0,0 +1,53 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include <rime/dict/table.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+// maps the table file and verifies its header, as when a schema is loaded.
+static void BM_TableLoad(benchmark::State& state) {
+  if (!PrepareLunaPinyin()) {
+    state.SkipWithError("failed to deploy luna_pinyin.");
+    return;
+  }
+  const path file_path = StagingFile("luna_pinyin.table.bin");
+  for (auto _ : state) {
+    Table table(file_path);
+    if (!table.Load()) {
+      state.SkipWithError("failed to load table.");
+      return;
+    }
+    benchmark::DoNotOptimize(table.metadata());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TableLoad);
+
+// queries the table at every syllable boundary of a long, ambiguous input.
+static void BM_TableQuery(benchmark::State& state) {
+  Dictionary* dict = LunaPinyinDictionary();
+  SyllableGraph graph;
+  const string input = string(kLunaPinyinInput).substr(0, state.range(0));
+  if (!dict || !SyllabifyLunaPinyin(input, &graph)) {
+    state.SkipWithError("failed to prepare luna_pinyin.");
+    return;
+  }
+  Table* table = dict->primary_table().get();
+  size_t num_queries = 0;
+  for (auto _ : state) {
+    for (const auto& x : graph.edges) {
+      TableQueryResult result;
+      benchmark::DoNotOptimize(table->Query(graph, x.first, &result));
+      ++num_queries;
+    }
+  }
+  state.SetItemsProcessed(num_queries);
+}
+BENCHMARK(BM_TableQuery)->RangeMultiplier(4)->Range(4, 64);
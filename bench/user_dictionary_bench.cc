@@ -0,0 +1,153 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <benchmark/benchmark.h>
+#include <rime/common.h>
+#include <rime/schema.h>
+#include <rime/ticket.h>
+#include <rime/algo/syllabifier.h>
+#include <rime/dict/dictionary.h>
+#include <rime/dict/level_db.h>
+#include <rime/dict/user_db.h>
+#include <rime/dict/user_dictionary.h>
+#include "luna_pinyin.h"
+
+using namespace rime;
+
+// learns the top few words at every syllable boundary of the bench input.
+static bool LearnWords(UserDictionary* user_dict) {
+  Dictionary* dict = LunaPinyinDictionary();
+  SyllableGraph graph;
+  if (!dict || !SyllabifyLunaPinyin(kLunaPinyinInput, &graph)) {
+    return false;
+  }
+  user_dict->Attach(dict->primary_table(), dict->prism());
+  const int kMaxLearnedWords = 4;
+  for (const auto& x : graph.edges) {
+    auto collector = dict->Lookup(graph, x.first);
+    if (!collector)
+      continue;
+    for (auto& y : *collector) {
+      for (int i = 0; i < kMaxLearnedWords && !y.second.exhausted(); ++i) {
+        user_dict->UpdateEntry(*y.second.Peek(), 1);
+        y.second.Next();
+      }
+    }
+  }
+  return true;
+}
+
+// a user dictionary that has learned the words of the bench input.
+static UserDictionary* PrepareUserDictionary() {
+  static the<UserDictionary> user_dict;
+  if (user_dict) {
+    return user_dict.get();
+  }
+  Schema* schema = PrepareLunaPinyin();
+  if (!schema) {
+    return nullptr;
+  }
+  if (auto c = UserDictionary::Require("user_dictionary")) {
+    user_dict.reset(c->Create(Ticket(schema, "translator")));
+  }
+  if (!user_dict || !user_dict->Load() || !LearnWords(user_dict.get())) {
+    user_dict.reset();
+    return nullptr;
+  }
+  return user_dict.get();
+}
+
+static void BM_UserDictionaryLookup(benchmark::State& state) {
+  UserDictionary* user_dict = PrepareUserDictionary();
+  SyllableGraph graph;
+  const string input = string(kLunaPinyinInput).substr(0, state.range(0));
+  if (!user_dict || !SyllabifyLunaPinyin(input, &graph)) {
+    state.SkipWithError("failed to prepare user dictionary.");
+    return;
+  }
+  // the depth limit used by script_translator when making sentences
+  const size_t kDepthLimit = 5;
+  size_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const auto& x : graph.edges) {
+      benchmark::DoNotOptimize(user_dict->Lookup(graph, x.first, kDepthLimit));
+      ++num_lookups;
+    }
+  }
+  state.SetItemsProcessed(num_lookups);
+}
+BENCHMARK(BM_UserDictionaryLookup)->RangeMultiplier(4)->Range(4, 64);
+
+static const struct {
+  const char* label;
+  LevelDbOptions options;
+} kLevelDbOptions[] = {
+    {"default", {}},
+    {"fill_cache", {0, 0, 0, true, true}},
+    {"bloom_filter", {0, 10, 0, true, true}},
+    {"small_cache", {1 << 20, 10, 0, true, true}},
+    {"no_compression", {0, 10, 0, false, true}},
+};
+
+// looks up words in a user dictionary read from leveldb without the
+// in-memory cache, as tuned by the options; reports the memory leveldb takes.
+static void BM_LevelDbUserDictionaryLookup(benchmark::State& state) {
+  const auto& tuning = kLevelDbOptions[state.range(0)];
+  state.SetLabel(tuning.label);
+  SyllableGraph graph;
+  const string input = string(kLunaPinyinInput).substr(0, 16);
+  if (!PrepareLunaPinyin() || !SyllabifyLunaPinyin(input, &graph)) {
+    state.SkipWithError("failed to prepare luna_pinyin.");
+    return;
+  }
+  const path db_file("leveldb_bench.userdb");
+  static bool learned = false;
+  if (!learned) {
+    auto db = New<UserDbWrapper<LevelDb>>(db_file, "leveldb_bench");
+    db->Remove();
+    UserDictionary user_dict("leveldb_bench", db);
+    learned = user_dict.Load() && LearnWords(&user_dict);
+    if (!learned) {
+      state.SkipWithError("failed to prepare user dictionary.");
+      return;
+    }
+  }
+  auto db = New<UserDbWrapper<LevelDb>>(db_file, "leveldb_bench");
+  db->set_options(tuning.options);
+  UserDictionary user_dict("leveldb_bench", db);
+  Dictionary* dict = LunaPinyinDictionary();
+  if (!user_dict.Load()) {
+    state.SkipWithError("failed to open user dictionary.");
+    return;
+  }
+  user_dict.Attach(dict->primary_table(), dict->prism());
+  const size_t kDepthLimit = 5;
+  size_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const auto& x : graph.edges) {
+      benchmark::DoNotOptimize(user_dict.Lookup(graph, x.first, kDepthLimit));
+      ++num_lookups;
+    }
+  }
+  state.SetItemsProcessed(num_lookups);
+  state.counters["memory"] = double(db->ApproximateMemoryUsage());
+}
+BENCHMARK(BM_LevelDbUserDictionaryLookup)->DenseRange(0, 4);
+
+// decoding the value of every record scanned by a lookup, in the legacy
+// text format (0) and the binary format (1).
+static void BM_UnpackUserDbValue(benchmark::State& state) {
+  UserDbValue v;
+  v.commits = 42;
+  v.dee = 3.1415926;
+  v.tick = 123456;
+  const string value = state.range(0) ? v.Pack() : v.PackText();
+  for (auto _ : state) {
+    UserDbValue u;
+    benchmark::DoNotOptimize(u.Unpack(value));
+    benchmark::DoNotOptimize(u);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UnpackUserDbValue)->Arg(0)->Arg(1);
@@ -234,8 +234,7 @@ int TableEncoder::CalculateCodeIndex(const string& code, int index, int start) {
 }
 
 bool TableEncoder::EncodePhrase(const string& phrase, const string& value) {
-  size_t phrase_length = utf8::unchecked::distance(
-      phrase.c_str(), phrase.c_str() + phrase.length());
+  size_t phrase_length = strings::utf8_length(phrase);
   if (static_cast<int>(phrase_length) > max_phrase_length_)
     return false;
 
@@ -292,8 +291,7 @@ bool TableEncoder::DfsEncode(const string& phrase,
 ScriptEncoder::ScriptEncoder(PhraseCollector* collector) : Encoder(collector) {}
 
 bool ScriptEncoder::EncodePhrase(const string& phrase, const string& value) {
-  size_t phrase_length = utf8::unchecked::distance(
-      phrase.c_str(), phrase.c_str() + phrase.length());
+  size_t phrase_length = strings::utf8_length(phrase);
   if (static_cast<int>(phrase_length) > kMaxPhraseLength)
     return false;
 
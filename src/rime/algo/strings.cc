@@ -1,5 +1,15 @@
+#include <cstring>
 #include <rime/algo/strings.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RIME_STRINGS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RIME_STRINGS_NEON
+#endif
+
 namespace rime {
 namespace strings {
 
@@ -7,25 +17,32 @@ vector<string> split(const string& str,
                      const string& delim,
                      SplitBehavior behavior) {
   vector<string> strings;
+  // a single delimiter is searched with memchr; otherwise by table lookup.
+  const ByteSet delim_set(delim);
+  auto find_delim = [&](size_t pos) {
+    if (delim.length() == 1)
+      return str.find(delim[0], pos);
+    return delim_set.find_in(str, pos);
+  };
   size_t lastPos, pos;
   if (behavior == SplitBehavior::SkipToken) {
-    lastPos = str.find_first_not_of(delim, 0);
+    lastPos = delim_set.find_not_in(str, 0);
   } else {
     lastPos = 0;
   }
-  pos = str.find_first_of(delim, lastPos);
+  pos = find_delim(lastPos);
 
   while (std::string::npos != pos || std::string::npos != lastPos) {
     strings.emplace_back(str.substr(lastPos, pos - lastPos));
     if (behavior == SplitBehavior::SkipToken) {
-      lastPos = str.find_first_not_of(delim, pos);
+      lastPos = delim_set.find_not_in(str, pos);
     } else {
       if (pos == std::string::npos) {
         break;
       }
       lastPos = pos + 1;
     }
-    pos = str.find_first_of(delim, lastPos);
+    pos = find_delim(lastPos);
   }
   return strings;
 };
@@ -34,5 +51,148 @@ vector<string> split(const string& str, const string& delim) {
   return split(str, delim, SplitBehavior::KeepToken);
 };
 
+// continuation bytes 10xxxxxx are -128 to -65 as signed chars;
+// each of the other bytes starts a code point.
+inline static bool starts_code_point(char c) {
+  return static_cast<signed char>(c) > -65;
+}
+
+size_t utf8_length(const char* begin, const char* end) {
+  size_t length = 0;
+  const char* p = begin;
+#if defined(RIME_STRINGS_SSE2)
+  const __m128i continuation_max = _mm_set1_epi8(-65);
+  while (end - p >= 16) {
+    // per byte counters, summed up before they could overflow
+    __m128i counts = _mm_setzero_si128();
+    for (int i = 0; i < 255 && end - p >= 16; ++i, p += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(chunk, continuation_max));
+    }
+    __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    length += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+  }
+#elif defined(RIME_STRINGS_NEON)
+  const int8x16_t continuation_max = vdupq_n_s8(-65);
+  for (; end - p >= 16; p += 16) {
+    int8x16_t chunk = vld1q_s8(reinterpret_cast<const int8_t*>(p));
+    uint8x16_t starts = vcgtq_s8(chunk, continuation_max);
+    length += vaddvq_u8(vandq_u8(starts, vdupq_n_u8(1)));
+  }
+#endif
+  // 8 bytes at a time; the top byte of the product sums up the flags
+  const uint64_t kLowBits = 0x0101010101010101;
+  for (; end - p >= 8; p += 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    uint64_t continuation = (word >> 7) & ~(word >> 6) & kLowBits;
+    length += 8 - ((continuation * kLowBits) >> 56);
+  }
+  for (; p < end; ++p) {
+    length += starts_code_point(*p);
+  }
+  return length;
+}
+
+// length of the sequence led by the byte; 0 if it cannot lead one.
+inline static int utf8_sequence_length(unsigned char lead) {
+  if (lead < 0x80)
+    return 1;
+  if (lead < 0xC2)  // continuation byte, or an overlong 2-byte sequence
+    return 0;
+  if (lead < 0xE0)
+    return 2;
+  if (lead < 0xF0)
+    return 3;
+  if (lead < 0xF5)
+    return 4;
+  return 0;
+}
+
+bool utf8_valid(const char* begin, const char* end) {
+  auto p = reinterpret_cast<const unsigned char*>(begin);
+  auto e = reinterpret_cast<const unsigned char*>(end);
+  const uint64_t kHighBits = 0x8080808080808080;
+  while (p < e) {
+    // runs of ASCII characters are skipped a vector, then a word at a time
+#if defined(RIME_STRINGS_SSE2)
+    while (e - p >= 16 &&
+           !_mm_movemask_epi8(
+               _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))) {
+      p += 16;
+    }
+#elif defined(RIME_STRINGS_NEON)
+    while (e - p >= 16 && !(vmaxvq_u8(vld1q_u8(p)) & 0x80)) {
+      p += 16;
+    }
+#endif
+    for (; e - p >= 8; p += 8) {
+      uint64_t word;
+      std::memcpy(&word, p, sizeof(word));
+      if (word & kHighBits)
+        break;
+    }
+    while (p < e && *p < 0x80) {
+      ++p;
+    }
+    // then sequences of other characters one by one
+    while (p < e && *p >= 0x80) {
+      int length = utf8_sequence_length(*p);
+      if (length == 0 || e - p < length)
+        return false;
+      // the second byte is further limited, so as to rule out overlong
+      // sequences, surrogates and code points beyond U+10FFFF
+      unsigned char min = 0x80, max = 0xBF;
+      switch (*p) {
+        case 0xE0:
+          min = 0xA0;
+          break;
+        case 0xED:
+          max = 0x9F;
+          break;
+        case 0xF0:
+          min = 0x90;
+          break;
+        case 0xF4:
+          max = 0x8F;
+          break;
+      }
+      if (p[1] < min || p[1] > max)
+        return false;
+      for (int i = 2; i < length; ++i) {
+        if ((p[i] & 0xC0) != 0x80)
+          return false;
+      }
+      p += length;
+    }
+  }
+  return true;
+}
+
+bool is_ascii(const char* begin, const char* end) {
+  const char* p = begin;
+#if defined(RIME_STRINGS_SSE2)
+  __m128i bits = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16) {
+    bits = _mm_or_si128(
+        bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+  if (_mm_movemask_epi8(bits))
+    return false;
+#elif defined(RIME_STRINGS_NEON)
+  uint8x16_t bits = vdupq_n_u8(0);
+  for (; end - p >= 16; p += 16) {
+    bits = vorrq_u8(bits, vld1q_u8(reinterpret_cast<const uint8_t*>(p)));
+  }
+  if (vmaxvq_u8(bits) & 0x80)
+    return false;
+#endif
+  for (; p < end; ++p) {
+    if (*p & 0x80)
+      return false;
+  }
+  return true;
+}
+
 }  // namespace strings
 }  // namespace rime
@@ -2,6 +2,7 @@
 #define RIME_STRINGS_H_
 
 #include <rime/common.h>
+#include <cstdint>
 #include <initializer_list>
 
 namespace rime {
@@ -15,6 +16,63 @@ vector<string> split(const string& str,
 
 vector<string> split(const string& str, const string& delim);
 
+// counts the code points of a valid UTF-8 string.
+size_t utf8_length(const char* begin, const char* end);
+
+inline size_t utf8_length(const string& str) {
+  return utf8_length(str.data(), str.data() + str.length());
+}
+
+// whether the string is well-formed UTF-8, with no overlong sequences,
+// surrogates or code points beyond U+10FFFF.
+bool utf8_valid(const char* begin, const char* end);
+
+inline bool utf8_valid(const string& str) {
+  return utf8_valid(str.data(), str.data() + str.length());
+}
+
+// whether the string is made of ASCII characters only.
+bool is_ascii(const char* begin, const char* end);
+
+inline bool is_ascii(const string& str) {
+  return is_ascii(str.data(), str.data() + str.length());
+}
+
+// a set of bytes, such as delimiters, tested by table lookup rather than
+// searching the set for every byte scanned.
+class ByteSet {
+ public:
+  explicit ByteSet(const string& bytes) {
+    for (unsigned char c : bytes) {
+      bits_[c >> 6] |= uint64_t(1) << (c & 63);
+    }
+  }
+
+  bool contains(char c) const {
+    unsigned char b = static_cast<unsigned char>(c);
+    return (bits_[b >> 6] >> (b & 63)) & 1;
+  }
+  // position of the first byte at or after pos in (or not in) the set;
+  // string::npos if there is none.
+  size_t find_in(const string& str, size_t pos = 0) const {
+    for (; pos < str.length(); ++pos) {
+      if (contains(str[pos]))
+        return pos;
+    }
+    return string::npos;
+  }
+  size_t find_not_in(const string& str, size_t pos = 0) const {
+    for (; pos < str.length(); ++pos) {
+      if (!contains(str[pos]))
+        return pos;
+    }
+    return string::npos;
+  }
+
+ private:
+  uint64_t bits_[4] = {};
+};
+
 template <typename Iter, typename T>
 string join(Iter start, Iter end, T&& delim) {
   string result;
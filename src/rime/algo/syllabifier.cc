@@ -6,6 +6,7 @@
 // 2012-02-11 GONG Chen <chen.sst@gmail.com>
 //
 #include <queue>
+#include <boost/functional/hash.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <rime/algo/syllabifier.h>
 #include <rime/dict/corrector.h>
@@ -26,15 +27,75 @@ using VertexQueue =
 const double kCompletionPenalty = -2.995732273553991;      // log(0.05)
 const double kCorrectionCredibility = -4.605170185988091;  // log(0.01)
 
+// moves an edge pruned from the graph to where it is kept, if any.
+static void prune_edge(EndVertexMap* edges,
+                       EndVertexMap::iterator edge,
+                       EndVertexMap* pruned) {
+  if (pruned) {
+    auto found = pruned->find(edge->first);
+    if (found == pruned->end()) {
+      pruned->insert(edges->extract(edge));
+      return;
+    }
+    found->second.merge(edge->second);
+  }
+  edges->erase(edge);
+}
+
 int Syllabifier::BuildSyllableGraph(const string& input,
                                     Prism& prism,
                                     SyllableGraph* graph) {
-  if (input.empty())
+  // the cache only builds on graphs it has handed out
+  if (cache_)
+    cache_->graph_.reset();
+  return Build(input, prism, graph);
+}
+
+int Syllabifier::Build(const string& input,
+                       Prism& prism,
+                       SyllableGraph* graph) {
+  if (input.empty()) {
+    if (cache_)
+      cache_->clear();
     return 0;
+  }
+
+  // vertices searched for the last input remain valid as long as the part
+  // of input they have read is unchanged. their edges are found in the last
+  // graph, and in the cache if pruned.
+  size_t common_prefix_length = 0;
+  map<size_t, SyllableGraphCache::Vertex> cached_vertices;
+  EdgeMap last_edges;
+  if (cache_) {
+    if (cache_->prism_ == &prism) {
+      const string& last_input(cache_->input_);
+      common_prefix_length = std::mismatch(input.begin(), input.end(),
+                                           last_input.begin(), last_input.end())
+                                 .first -
+                             input.begin();
+      if (auto last_graph = std::move(cache_->graph_)) {
+        cached_vertices.swap(cache_->vertices_);
+        // the last graph is left intact for whoever still holds it
+        if (last_graph.use_count() == 1) {
+          last_edges.swap(last_graph->edges);
+        } else {
+          last_edges = last_graph->edges;
+        }
+      } else {
+        cache_->vertices_.clear();
+      }
+    } else {
+      cache_->clear();
+      cache_->prism_ = &prism;
+    }
+    cache_->input_ = input;
+  }
 
   size_t farthest = 0;
   VertexQueue queue;
   queue.push(Vertex{0, kNormalSpelling});  // start
+  // reused across vertices when there is no cache
+  SyllableGraphCache::Vertex searched;
 
   while (!queue.empty()) {
     Vertex vertex(queue.top());
@@ -55,90 +116,38 @@ int Syllabifier::BuildSyllableGraph(const string& input,
     DLOG(INFO) << "current_pos: " << current_pos;
 
     // see where we can go by advancing a syllable
-    vector<Prism::Match> matches;
-    set<SyllableId> exact_match_syllables;
-    auto current_input = input.substr(current_pos);
-    prism.CommonPrefixSearch(current_input, &matches);
-    if (corrector_) {
-      for (auto& m : matches) {
-        exact_match_syllables.insert(m.value);
+    SyllableGraphCache::Vertex* result = &searched;
+    bool reused = false;
+    if (cache_) {
+      auto found = cached_vertices.find(current_pos);
+      if (found != cached_vertices.end() &&
+          found->second.horizon <= common_prefix_length) {
+        DLOG(INFO) << "reuse vertex at " << current_pos;
+        result = &cache_->vertices_.insert(cached_vertices.extract(found))
+                      .position->second;
+        RestoreEdges(current_pos, result, &last_edges, graph);
+        reused = true;
+      } else {
+        result = &cache_->vertices_[current_pos];
       }
-      Corrections corrections;
-      corrector_->ToleranceSearch(prism, current_input, &corrections, 5);
-      for (const auto& m : corrections) {
-        for (auto accessor = prism.QuerySpelling(m.first);
-             !accessor.exhausted(); accessor.Next()) {
-          auto props = accessor.properties();
-          if (props.type == kNormalSpelling && !props.is_correction) {
-            matches.push_back({m.first, m.second.length});
-            break;
-          }
-        }
+    }
+    if (!reused) {
+      SearchVertex(input, current_pos, prism, result);
+      if (result->matched) {
+        graph->edges[current_pos] = std::move(result->edges);
       }
+      result->edges.clear();
     }
 
-    if (!matches.empty()) {
-      auto& end_vertices(graph->edges[current_pos]);
-      for (const auto& m : matches) {
-        if (m.length == 0)
-          continue;
-        size_t end_pos = current_pos + m.length;
-        // consume trailing delimiters
-        while (end_pos < input.length() &&
-               delimiters_.find(input[end_pos]) != string::npos)
-          ++end_pos;
-        DLOG(INFO) << "end_pos: " << end_pos;
-        bool matches_input = (current_pos == 0 && end_pos == input.length());
-        SpellingMap& spellings(end_vertices[end_pos]);
-        SpellingType end_vertex_type = kInvalidSpelling;
-        // when spelling algebra is enabled,
-        // a spelling evaluates to a set of syllables;
-        // otherwise, it resembles exactly the syllable itself.
-        SpellingAccessor accessor(prism.QuerySpelling(m.value));
-        while (!accessor.exhausted()) {
-          SyllableId syllable_id = accessor.syllable_id();
-          EdgeProperties props(accessor.properties());
-          if (strict_spelling_ && matches_input &&
-              props.type != kNormalSpelling) {
-            // disqualify fuzzy spelling or abbreviation as single word
-          } else {
-            props.end_pos = end_pos;
-            // add a syllable with properties to the edge's
-            // spelling-to-syllable map
-            if (corrector_ && exact_match_syllables.find(m.value) ==
-                                  exact_match_syllables.end()) {
-              props.is_correction = true;
-              props.credibility = kCorrectionCredibility;
-            }
-            auto it = spellings.find(syllable_id);
-            if (it == spellings.end()) {
-              spellings.insert({syllable_id, props});
-            } else {
-              it->second.type = (std::min)(it->second.type, props.type);
-            }
-            // let end_vertex_type be the best (smaller) type of spelling
-            // that ends at the vertex
-            if (end_vertex_type > props.type && !props.is_correction) {
-              end_vertex_type = props.type;
-            }
-          }
-          accessor.Next();
-        }
-        if (spellings.empty()) {
-          DLOG(INFO) << "not spelled.";
-          end_vertices.erase(end_pos);
-          continue;
-        }
-        // find the best common type in a path up to the end vertex
-        // eg. pinyin "shurfa" has vertex type kNormalSpelling at position 3,
-        // kAbbreviation at position 4 and kAbbreviation at position 6
-        if (end_vertex_type < vertex.second) {
-          end_vertex_type = vertex.second;
-        }
-        queue.push(Vertex{end_pos, end_vertex_type});
-        DLOG(INFO) << "added to syllable graph, edge: [" << current_pos << ", "
-                   << end_pos << ")";
-      }
+    for (const auto& end_vertex : result->end_vertex_types) {
+      // find the best common type in a path up to the end vertex
+      // eg. pinyin "shurfa" has vertex type kNormalSpelling at position 3,
+      // kAbbreviation at position 4 and kAbbreviation at position 6
+      SpellingType end_vertex_type =
+          (std::max)(end_vertex.second, vertex.second);
+      queue.push(Vertex{end_vertex.first, end_vertex_type});
+      DLOG(INFO) << "added to syllable graph, edge: [" << current_pos << ", "
+                 << end_vertex.first << ")";
     }
   }
 
@@ -151,11 +160,13 @@ int Syllabifier::BuildSyllableGraph(const string& input,
   for (int i = farthest - 1; i >= 0; --i) {
     if (graph->vertices.find(i) == graph->vertices.end())
       continue;
+    // what is removed is kept for rebuilding the graph
+    EndVertexMap* pruned = PrunedEdges(i);
     // remove stale edges
     for (auto j = graph->edges[i].begin(); j != graph->edges[i].end();) {
       if (good.find(j->first) == good.end()) {
         // not connected
-        graph->edges[i].erase(j++);
+        prune_edge(&graph->edges[i], j++, pruned);
         continue;
       }
       // remove disqualified syllables (eg. matching abbreviated spellings)
@@ -167,7 +178,11 @@ int Syllabifier::BuildSyllableGraph(const string& input,
           continue;  // Don't care correction edges
         }
         if (k->second.type > last_type) {
-          j->second.erase(k++);
+          if (pruned) {
+            (*pruned)[j->first].insert(j->second.extract(k++));
+          } else {
+            j->second.erase(k++);
+          }
         } else {
           if (k->second.type < edge_type)
             edge_type = k->second.type;
@@ -184,6 +199,10 @@ int Syllabifier::BuildSyllableGraph(const string& input,
     }
     if (graph->vertices[i] > last_type || graph->edges[i].empty()) {
       DLOG(INFO) << "remove stale vertex at " << i;
+      auto& edges(graph->edges[i]);
+      while (!edges.empty()) {
+        prune_edge(&edges, edges.begin(), pruned);
+      }
       graph->vertices.erase(i);
       graph->edges.erase(i);
       continue;
@@ -194,6 +213,10 @@ int Syllabifier::BuildSyllableGraph(const string& input,
 
   if (enable_completion_ && farthest < input.length()) {
     DLOG(INFO) << "completion enabled";
+    if (cache_) {
+      // completions depend on the rest of input
+      cache_->vertices_[farthest].horizon = input.length() + 1;
+    }
     const size_t kExpandSearchLimit = 512;
     vector<Prism::Match> keys;
     prism.ExpandSearch(input.substr(farthest), &keys, kExpandSearchLimit);
@@ -240,11 +263,165 @@ int Syllabifier::BuildSyllableGraph(const string& input,
   DLOG(INFO) << "input length: " << graph->input_length;
   DLOG(INFO) << "syllabified length: " << graph->interpreted_length;
 
+  if (cache_) {
+    UpdateDigests(graph, common_prefix_length);
+  }
   Transpose(graph);
 
   return farthest;
 }
 
+an<const SyllableGraph> Syllabifier::BuildSyllableGraph(const string& input,
+                                                        Prism& prism) {
+  if (input.empty()) {
+    if (cache_)
+      cache_->clear();
+    return New<SyllableGraph>();
+  }
+  auto graph = New<SyllableGraph>();
+  if (cache_ && cache_->prism_ == &prism && cache_->graph_) {
+    graph->previous_revision = cache_->graph_->revision;
+  }
+  Build(input, prism, graph.get());
+  if (cache_) {
+    graph->revision = ++cache_->revision_;
+    cache_->graph_ = graph;
+  }
+  return graph;
+}
+
+void Syllabifier::SearchVertex(const string& input,
+                               size_t current_pos,
+                               Prism& prism,
+                               SyllableGraphCache::Vertex* result) {
+  result->matched = false;
+  result->edges.clear();
+  result->end_vertex_types.clear();
+  // spellings matched depend on input read by the trie, up to the first
+  // character that falls off the trie, or the end of input.
+  if (corrector_) {
+    // corrections may read any part of the remaining input
+    result->horizon = input.length() + 1;
+  } else {
+    size_t node_pos = 0;
+    size_t key_pos = 0;
+    int ret = prism.trie().traverse(input.c_str() + current_pos, node_pos,
+                                    key_pos, input.length() - current_pos);
+    result->horizon =
+        ret == -2 ? current_pos + key_pos + 1 : input.length() + 1;
+  }
+
+  vector<Prism::Match> matches;
+  set<SyllableId> exact_match_syllables;
+  auto current_input = input.substr(current_pos);
+  prism.CommonPrefixSearch(current_input, &matches);
+  if (corrector_) {
+    for (auto& m : matches) {
+      exact_match_syllables.insert(m.value);
+    }
+    Corrections corrections;
+    corrector_->ToleranceSearch(prism, current_input, &corrections, 5);
+    for (const auto& m : corrections) {
+      for (auto accessor = prism.QuerySpelling(m.first); !accessor.exhausted();
+           accessor.Next()) {
+        auto props = accessor.properties();
+        if (props.type == kNormalSpelling && !props.is_correction) {
+          matches.push_back({m.first, m.second.length});
+          break;
+        }
+      }
+    }
+  }
+
+  if (matches.empty())
+    return;
+  result->matched = true;
+  auto& end_vertices(result->edges);
+  for (const auto& m : matches) {
+    if (m.length == 0)
+      continue;
+    size_t end_pos = current_pos + m.length;
+    // consume trailing delimiters
+    while (end_pos < input.length() &&
+           delimiters_.find(input[end_pos]) != string::npos)
+      ++end_pos;
+    // having read up to the first non-delimiter character
+    result->horizon = (std::max)(result->horizon, end_pos + 1);
+    DLOG(INFO) << "end_pos: " << end_pos;
+    bool matches_input = (current_pos == 0 && end_pos == input.length());
+    SpellingMap& spellings(end_vertices[end_pos]);
+    SpellingType end_vertex_type = kInvalidSpelling;
+    // when spelling algebra is enabled,
+    // a spelling evaluates to a set of syllables;
+    // otherwise, it resembles exactly the syllable itself.
+    SpellingAccessor accessor(prism.QuerySpelling(m.value));
+    while (!accessor.exhausted()) {
+      SyllableId syllable_id = accessor.syllable_id();
+      EdgeProperties props(accessor.properties());
+      if (strict_spelling_ && matches_input && props.type != kNormalSpelling) {
+        // disqualify fuzzy spelling or abbreviation as single word
+      } else {
+        props.end_pos = end_pos;
+        // add a syllable with properties to the edge's
+        // spelling-to-syllable map
+        if (corrector_ && exact_match_syllables.find(m.value) ==
+                              exact_match_syllables.end()) {
+          props.is_correction = true;
+          props.credibility = kCorrectionCredibility;
+        }
+        auto it = spellings.find(syllable_id);
+        if (it == spellings.end()) {
+          spellings.insert({syllable_id, props});
+        } else {
+          it->second.type = (std::min)(it->second.type, props.type);
+        }
+        // let end_vertex_type be the best (smaller) type of spelling
+        // that ends at the vertex
+        if (end_vertex_type > props.type && !props.is_correction) {
+          end_vertex_type = props.type;
+        }
+      }
+      accessor.Next();
+    }
+    if (spellings.empty()) {
+      DLOG(INFO) << "not spelled.";
+      end_vertices.erase(end_pos);
+      continue;
+    }
+    result->end_vertex_types.push_back({end_pos, end_vertex_type});
+  }
+}
+
+EndVertexMap* Syllabifier::PrunedEdges(size_t pos) {
+  if (!cache_)
+    return nullptr;
+  auto found = cache_->vertices_.find(pos);
+  return found != cache_->vertices_.end() ? &found->second.edges : nullptr;
+}
+
+void Syllabifier::RestoreEdges(size_t pos,
+                               SyllableGraphCache::Vertex* cached,
+                               EdgeMap* last_edges,
+                               SyllableGraph* graph) {
+  if (!cached->matched)
+    return;
+  auto node = last_edges->extract(pos);
+  auto& edges(node.empty()
+                  ? graph->edges[pos]
+                  : graph->edges.insert(std::move(node)).position->second);
+  // put back pruned edges
+  auto& pruned(cached->edges);
+  while (!pruned.empty()) {
+    prune_edge(&pruned, pruned.begin(), &edges);
+  }
+  // ambiguity is marked again when pruning the new graph
+  for (auto& end : edges) {
+    for (auto& spelling : end.second) {
+      spelling.second.ambiguous_source_positions.clear();
+    }
+  }
+}
+
 void Syllabifier::CheckOverlappedSpellings(SyllableGraph* graph,
                                            size_t start,
                                            size_t end) {
@@ -269,7 +446,7 @@ void Syllabifier::CheckOverlappedSpellings(SyllableGraph* graph,
         // bad cases include pinyin syllabification "niju'ede"
         for (auto& spelling : x.second) {
           // 這條邊（X）相對於起點構成歧義
-          spelling.second.ambiguous_source_positions.insert(start);
+          spelling.second.AddAmbiguousSourcePosition(start);
         }
         graph->vertices[joint] = kAmbiguousSpelling;
         DLOG(INFO) << "ambiguous syllable joint at position " << joint << ".";
@@ -279,20 +456,163 @@ void Syllabifier::CheckOverlappedSpellings(SyllableGraph* graph,
   }
 }
 
-void Syllabifier::Transpose(SyllableGraph* graph) {
-  for (const auto& start : graph->edges) {
-    auto& index(graph->indices[start.first]);
-    for (const auto& end : boost::adaptors::reverse(start.second)) {
-      for (const auto& spelling : end.second) {
-        SyllableId syll_id = spelling.first;
-        index[syll_id].push_back(&spelling.second);
+void Syllabifier::UpdateDigests(SyllableGraph* graph,
+                                size_t common_prefix_length) {
+  vector<size_t> digests(graph->input_length + 1);
+  for (const auto& v : graph->vertices) {
+    size_t seed = 0;
+    boost::hash_combine(seed, static_cast<int>(v.second));
+    auto start = graph->edges.find(v.first);
+    if (start != graph->edges.end()) {
+      for (const auto& end : start->second) {
+        boost::hash_combine(seed, end.first);
+        for (const auto& spelling : end.second) {
+          const EdgeProperties& props(spelling.second);
+          boost::hash_combine(seed, spelling.first);
+          boost::hash_combine(seed, static_cast<int>(props.type));
+          boost::hash_combine(seed, props.credibility);
+          boost::hash_combine(seed, props.is_correction);
+          boost::hash_range(seed, props.ambiguous_source_positions.begin(),
+                            props.ambiguous_source_positions.end());
+        }
       }
     }
+    // tell a vertex from none
+    digests[v.first] = seed | 1;
+  }
+  const auto& last_digests(cache_->digests_);
+  size_t stable_length = 0;
+  // edges are also told apart by the input they are spelled with, in case
+  // of colliding digests.
+  while (stable_length < graph->interpreted_length &&
+         stable_length < last_digests.size() &&
+         stable_length < common_prefix_length &&
+         digests[stable_length] == last_digests[stable_length]) {
+    ++stable_length;
   }
+  graph->stable_length = stable_length;
+  DLOG(INFO) << "stable length: " << stable_length;
+  cache_->digests_.swap(digests);
+}
+
+void Syllabifier::Transpose(SyllableGraph* graph) {
+  graph->indices.Build(graph->edges);
 }
 
 void Syllabifier::EnableCorrection(Corrector* corrector) {
   corrector_ = corrector;
 }
 
+void Syllabifier::EnableCache(SyllableGraphCache* cache) {
+  cache_ = cache;
+}
+
+// SyllableGraph members
+
+SyllableGraph::SyllableGraph(const SyllableGraph& other)
+    : input_length(other.input_length),
+      interpreted_length(other.interpreted_length),
+      stable_length(other.stable_length),
+      revision(other.revision),
+      previous_revision(other.previous_revision),
+      vertices(other.vertices),
+      edges(other.edges) {
+  if (!other.indices.empty())
+    indices.Build(edges);
+}
+
+SyllableGraph& SyllableGraph::operator=(const SyllableGraph& other) {
+  if (this != &other) {
+    *this = SyllableGraph(other);
+  }
+  return *this;
+}
+
+// SyllableGraphCache members
+
+void SyllableGraphCache::clear() {
+  prism_ = nullptr;
+  graph_.reset();
+  input_.clear();
+  vertices_.clear();
+  digests_.clear();
+}
+
+// SpellingIndex members
+
+SpellingIndex::const_iterator SpellingIndex::find(
+    SyllableId syllable_id) const {
+  auto it = std::lower_bound(begin_, end_, syllable_id,
+                             [](const SyllableSpellings& x, SyllableId id) {
+                               return x.syllable_id < id;
+                             });
+  return it != end_ && it->syllable_id == syllable_id ? it : end_;
+}
+
+// SpellingIndices members
+
+void SpellingIndices::clear() {
+  vertices_.clear();
+  is_vertex_.clear();
+  syllables_.clear();
+  spellings_.clear();
+}
+
+void SpellingIndices::Build(const EdgeMap& edges) {
+  clear();
+  if (edges.empty())
+    return;
+  size_t num_vertices = edges.rbegin()->first + 1;
+  size_t num_spellings = 0;
+  for (const auto& start : edges) {
+    for (const auto& end : start.second) {
+      num_spellings += end.second.size();
+    }
+  }
+  // offsets into syllables_ and spellings_ are recorded first and turned
+  // into pointers once both arrays stop growing.
+  vector<pair<size_t, size_t>> vertex_ranges(num_vertices);
+  vector<pair<size_t, size_t>> syllable_ranges;
+  is_vertex_.assign(num_vertices, false);
+  syllables_.reserve(num_spellings);
+  syllable_ranges.reserve(num_spellings);
+  spellings_.reserve(num_spellings);
+  vector<pair<SyllableId, const EdgeProperties*>> group;
+  for (const auto& start : edges) {
+    group.clear();
+    // longer edges come first
+    for (const auto& end : boost::adaptors::reverse(start.second)) {
+      for (const auto& spelling : end.second) {
+        group.push_back({spelling.first, &spelling.second});
+      }
+    }
+    std::stable_sort(group.begin(), group.end(),
+                     [](const auto& a, const auto& b) {
+                       return a.first < b.first;
+                     });
+    size_t first_syllable = syllables_.size();
+    for (size_t i = 0; i < group.size(); ++i) {
+      if (i == 0 || group[i].first != group[i - 1].first) {
+        syllables_.push_back({group[i].first, {}});
+        syllable_ranges.push_back({spellings_.size(), spellings_.size()});
+      }
+      spellings_.push_back(group[i].second);
+      ++syllable_ranges.back().second;
+    }
+    vertex_ranges[start.first] = {first_syllable, syllables_.size()};
+    is_vertex_[start.first] = true;
+  }
+  const auto* spellings = spellings_.data();
+  for (size_t i = 0; i < syllables_.size(); ++i) {
+    syllables_[i].spellings = {spellings + syllable_ranges[i].first,
+                               spellings + syllable_ranges[i].second};
+  }
+  const auto* syllables = syllables_.data();
+  vertices_.resize(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    vertices_[i] = {syllables + vertex_ranges[i].first,
+                    syllables + vertex_ranges[i].second};
+  }
+}
+
 }  // namespace rime
@@ -9,6 +9,8 @@
 #define RIME_SYLLABIFIER_H_
 
 #include <stdint.h>
+#include <algorithm>
+#include <boost/container/small_vector.hpp>
 #include <rime_api.h>
 #include <rime/common.h>
 #include "spelling.h"
@@ -24,7 +26,17 @@ struct EdgeProperties : SpellingProperties {
   EdgeProperties(SpellingProperties sup) : SpellingProperties(sup) {};
   EdgeProperties() = default;
   // 切分歧義編碼段的起始位置
-  set<size_t> ambiguous_source_positions;
+  boost::container::small_vector<size_t, 2> ambiguous_source_positions;
+
+  bool IsAmbiguousFrom(size_t start) const {
+    return std::find(ambiguous_source_positions.begin(),
+                     ambiguous_source_positions.end(),
+                     start) != ambiguous_source_positions.end();
+  }
+  void AddAmbiguousSourcePosition(size_t start) {
+    if (!IsAmbiguousFrom(start))
+      ambiguous_source_positions.push_back(start);
+  }
 };
 
 using SpellingMap = map<SyllableId, EdgeProperties>;
@@ -32,18 +44,142 @@ using VertexMap = map<size_t, SpellingType>;
 using EndVertexMap = map<size_t, SpellingMap>;
 using EdgeMap = map<size_t, EndVertexMap>;
 
-using SpellingPropertiesList = vector<const EdgeProperties*>;
-using SpellingIndex = map<SyllableId, SpellingPropertiesList>;
-using SpellingIndices = map<size_t, SpellingIndex>;
+// edges from a start vertex that spell the same syllable,
+// in descending order of end position.
+class SpellingPropertiesList {
+ public:
+  using const_iterator = const EdgeProperties* const*;
+
+  SpellingPropertiesList() = default;
+  SpellingPropertiesList(const_iterator begin, const_iterator end)
+      : begin_(begin), end_(end) {}
+
+  const_iterator begin() const { return begin_; }
+  const_iterator end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+  const EdgeProperties* operator[](size_t i) const { return begin_[i]; }
+
+ private:
+  const_iterator begin_ = nullptr;
+  const_iterator end_ = nullptr;
+};
+
+struct SyllableSpellings {
+  SyllableId syllable_id;
+  SpellingPropertiesList spellings;
+};
+
+// syllables spelled by edges from a start vertex, in ascending order of id.
+class SpellingIndex {
+ public:
+  using const_iterator = const SyllableSpellings*;
+
+  SpellingIndex() = default;
+  SpellingIndex(const_iterator begin, const_iterator end)
+      : begin_(begin), end_(end) {}
+
+  const_iterator begin() const { return begin_; }
+  const_iterator end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+  RIME_DLL const_iterator find(SyllableId syllable_id) const;
+
+ private:
+  const_iterator begin_ = nullptr;
+  const_iterator end_ = nullptr;
+};
+
+// the edge map transposed into a flat, compressed sparse row layout:
+// one contiguous array of syllables sorted by start vertex then syllable id,
+// and one array of edges grouped by syllable.
+// it points into its own arrays and into the nodes of the edge map it is
+// built from, so it can be moved along with the edge map but not copied.
+class SpellingIndices {
+ public:
+  SpellingIndices() = default;
+  SpellingIndices(const SpellingIndices&) = delete;
+  SpellingIndices& operator=(const SpellingIndices&) = delete;
+  SpellingIndices(SpellingIndices&&) = default;
+  SpellingIndices& operator=(SpellingIndices&&) = default;
+
+  RIME_DLL void Build(const EdgeMap& edges);
+  RIME_DLL void clear();
+  bool empty() const { return vertices_.empty(); }
+
+  // returns nullptr if no edges start at the vertex.
+  const SpellingIndex* find(size_t start_pos) const {
+    return start_pos < vertices_.size() && is_vertex_[start_pos]
+               ? &vertices_[start_pos]
+               : nullptr;
+  }
 
+ private:
+  vector<SpellingIndex> vertices_;
+  vector<bool> is_vertex_;
+  vector<SyllableSpellings> syllables_;
+  vector<const EdgeProperties*> spellings_;
+};
+
+// edges are kept in nested maps, as the syllabifier builds and prunes them;
+// indices are the flat layout for lookups. copying a graph rebuilds the
+// indices for the copied edges.
 struct SyllableGraph {
+  SyllableGraph() = default;
+  RIME_DLL SyllableGraph(const SyllableGraph& other);
+  SyllableGraph(SyllableGraph&&) = default;
+  RIME_DLL SyllableGraph& operator=(const SyllableGraph& other);
+  SyllableGraph& operator=(SyllableGraph&&) = default;
+
   size_t input_length = 0;
   size_t interpreted_length = 0;
+  // edges starting before this position are the same as in the graph last
+  // built with the same cache, and so are lookups of paths ending there.
+  size_t stable_length = 0;
+  // unique among graphs built with the same cache; 0 if built without one.
+  size_t revision = 0;
+  // revision of the graph that stable_length compares to.
+  size_t previous_revision = 0;
   VertexMap vertices;
   EdgeMap edges;
   SpellingIndices indices;
 };
 
+// keeps the last syllable graph and how it was searched, so that typing at
+// the end of input (or deleting from it) only searches from vertices near
+// the end. it is meant to be used with a single prism and syllabifier
+// settings.
+// graphs handed out are never modified; the next graph is built anew, with
+// edges taken from the last one, or copied if it is still in use.
+class SyllableGraphCache {
+ public:
+  void clear();
+
+ protected:
+  friend class Syllabifier;
+
+  struct Vertex {
+    // the search read input up to this position, exclusive;
+    // past the end of input if it depends on where input ends.
+    size_t horizon = 0;
+    bool matched = false;
+    // edges pruned from the graph
+    EndVertexMap edges;
+    // best spelling type of each edge, in the order they are found
+    vector<pair<size_t, SpellingType>> end_vertex_types;
+  };
+
+  const Prism* prism_ = nullptr;
+  string input_;
+  an<SyllableGraph> graph_;
+  map<size_t, Vertex> vertices_;
+  // fingerprints of pruned edges by start position
+  vector<size_t> digests_;
+  // revision of the last graph built; not reset by clear(), as graphs built
+  // before may still be around.
+  size_t revision_ = 0;
+};
+
 class Syllabifier {
  public:
   Syllabifier() = default;
@@ -57,16 +193,32 @@ class Syllabifier {
   RIME_DLL int BuildSyllableGraph(const string& input,
                                   Prism& prism,
                                   SyllableGraph* graph);
+  // builds on the graph last returned with the cache.
+  RIME_DLL an<const SyllableGraph> BuildSyllableGraph(const string& input,
+                                                      Prism& prism);
   RIME_DLL void EnableCorrection(Corrector* corrector);
+  RIME_DLL void EnableCache(SyllableGraphCache* cache);
 
  protected:
+  int Build(const string& input, Prism& prism, SyllableGraph* graph);
   void CheckOverlappedSpellings(SyllableGraph* graph, size_t start, size_t end);
   void Transpose(SyllableGraph* graph);
+  void SearchVertex(const string& input,
+                    size_t current_pos,
+                    Prism& prism,
+                    SyllableGraphCache::Vertex* result);
+  void RestoreEdges(size_t pos,
+                    SyllableGraphCache::Vertex* cached,
+                    EdgeMap* last_edges,
+                    SyllableGraph* graph);
+  EndVertexMap* PrunedEdges(size_t pos);
+  void UpdateDigests(SyllableGraph* graph, size_t common_prefix_length);
 
   string delimiters_;
   bool enable_completion_ = false;
   bool strict_spelling_ = false;
   Corrector* corrector_ = nullptr;
+  SyllableGraphCache* cache_ = nullptr;
 };
 
 }  // namespace rime
@@ -8,6 +8,8 @@
 #define RIME_UTILITIES_H_
 
 #include <stdint.h>
+#include <future>
+#include <type_traits>
 #include <boost/crc.hpp>
 #include <rime/common.h>
 
@@ -32,6 +34,19 @@ inline uint32_t Checksum(const path& file_path) {
   return c.Checksum();
 }
 
+// runs a task on another thread, or, if threading is disabled or not
+// parallel, on the thread that first waits for its result.
+template <class F>
+std::future<std::invoke_result_t<std::decay_t<F>>> RunAsync(
+    F&& task,
+    bool parallel = true) {
+#ifdef RIME_NO_THREADING
+  parallel = false;
+#endif
+  return std::async(parallel ? std::launch::async : std::launch::deferred,
+                    std::forward<F>(task));
+}
+
 }  // namespace rime
 
 #endif  // RIME_UTILITIES_H_
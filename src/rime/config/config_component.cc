@@ -181,6 +181,7 @@ Config* ConfigComponentBase::Create(const string& file_name) {
 
 an<ConfigData> ConfigComponentBase::GetConfigData(const string& file_name) {
   auto config_id = resource_resolver_->ToResourceId(file_name);
+  std::lock_guard<std::mutex> lock(mutex_);
   // keep a weak reference to the shared config data in the component
   weak<ConfigData>& wp(cache_[config_id]);
   if (wp.expired()) {  // create a new copy and load it
@@ -9,6 +9,7 @@
 #include <utility>
 #include <rime/common.h>
 #include <rime/deployer.h>
+#include <rime/resource_cache.h>
 
 namespace rime {
 
@@ -36,6 +37,8 @@ bool Deployer::RunTask(const string& task_name, TaskInitializer arg) {
     LOG(ERROR) << "error creating deployment task: " << task_name;
     return false;
   }
+  // let go of files the task may rebuild
+  ResourceCacheBase::ReleaseAllRetained();
   return t->Run(this);
 }
 
@@ -79,6 +82,8 @@ bool Deployer::HasPendingTasks() {
 bool Deployer::Run() {
   LOG(INFO) << "running deployment tasks:";
   message_sink_("deploy", "start");
+  // let go of files the tasks may rebuild
+  ResourceCacheBase::ReleaseAllRetained();
   int success = 0;
   int failure = 0;
   do {
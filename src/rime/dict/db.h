@@ -7,6 +7,8 @@
 #ifndef RIME_DB_H_
 #define RIME_DB_H_
 
+#include <atomic>
+#include <mutex>
 #include <rime_api.h>
 #include <rime/common.h>
 #include <rime/component.h>
@@ -64,12 +66,24 @@ class Db : public Class<Db, const string&> {
   void disable() { disabled_ = true; }
   void enable() { disabled_ = false; }
 
+  // held while opening a db shared by dictionaries in different sessions.
+  std::mutex& load_mutex() const { return load_mutex_; }
+
+  // bumped on each write by a user dictionary, so that sessions sharing
+  // the db can tell their cached translations are stale.
+  uint64_t generation() const { return generation_; }
+  void bump_generation() { ++generation_; }
+
  protected:
   string name_;
   path file_path_;
   bool loaded_ = false;
   bool readonly_ = false;
   bool disabled_ = false;
+
+ private:
+  mutable std::mutex load_mutex_;
+  std::atomic<uint64_t> generation_{0};
 };
 
 class Transactional {
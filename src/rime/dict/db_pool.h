@@ -3,6 +3,7 @@
 
 #include <rime/common.h>
 #include <rime/resource.h>
+#include <rime/resource_cache.h>
 
 namespace rime {
 
@@ -15,9 +16,11 @@ class DbPool {
 
   an<T> GetDb(const string& db_name);
 
+  ResourceCacheStats db_cache_stats() { return db_pool_.stats(); }
+
  protected:
   the<ResourceResolver> resource_resolver_;
-  map<string, weak<T>> db_pool_;
+  ResourceCache<T> db_pool_{SizeOfFile<T>};
 };
 
 }  // namespace rime
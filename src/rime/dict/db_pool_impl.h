@@ -12,13 +12,9 @@ DbPool<T>::DbPool(the<ResourceResolver> resource_resolver)
 
 template <class T>
 an<T> DbPool<T>::GetDb(const string& db_name) {
-  auto db = db_pool_[db_name].lock();
-  if (!db) {
-    auto file_path = resource_resolver_->ResolvePath(db_name);
-    db = New<T>(file_path);
-    db_pool_[db_name] = db;
-  }
-  return db;
+  return db_pool_.Get(db_name, [this, &db_name] {
+    return New<T>(resource_resolver_->ResolvePath(db_name));
+  });
 };
 
 }  // namespace rime
@@ -8,6 +8,7 @@
 #include <cfloat>
 #include <cmath>
 #include <fstream>
+#include <future>
 #include <rime/algo/algebra.h>
 #include <rime/algo/utilities.h>
 #include <rime/dict/corrector.h>
@@ -103,7 +104,8 @@ bool DictCompiler::Compile(const path& schema_file) {
   const auto& primary_table = tables_[0];
   if (primary_table->Exists() && primary_table->Load()) {
     if (build_table_from_source) {
-      rebuild_table = primary_table->dict_file_checksum() != dict_file_checksum;
+      rebuild_table = primary_table->outdated() ||
+                      primary_table->dict_file_checksum() != dict_file_checksum;
     } else {
       dict_file_checksum = primary_table->dict_file_checksum();
       LOG(INFO) << "reuse existing table: " << primary_table->file_path();
@@ -159,54 +161,71 @@ bool DictCompiler::Compile(const path& schema_file) {
       !BuildPrism(schema_file, dict_file_checksum, schema_file_checksum)) {
     return false;
   }
+  // packs depend only on the primary table, build them in parallel.
+  bool parallel = !(options_ & kSequential);
+  vector<std::future<void>> packs_built;
   for (int table_index = 1; table_index < tables_.size(); ++table_index) {
-    const auto& pack_name = packs_[table_index - 1];
-    auto pack_table = tables_[table_index];
-    EntryCollector collector(std::move(syllabary));
-    DictSettings settings;
-    auto dict_file = source_resolver_->ResolvePath(pack_name + ".dict.yaml");
-    if (!std::filesystem::exists(dict_file)) {
-      if (pack_table->Exists())
-        LOG(INFO) << "pack source file '" << dict_file
-                  << "' does not exist, using prebuilt table '"
-                  << pack_table->file_path() << "'";
-      else
-        LOG(ERROR) << "neither pack source file '" << dict_file
-                   << "' nor a prebuilt table exists";
-      continue;
-    }
-    if (!load_dict_settings_from_file(&settings, dict_file)) {
-      LOG(ERROR) << "failed to load settings from '" << dict_file << "'.";
-      continue;
-    }
-    vector<path> dict_files;
-    if (!get_dict_files_from_settings(&dict_files, settings,
-                                      source_resolver_.get())) {
-      continue;
-    }
-    uint32_t pack_file_checksum =
-        compute_dict_file_checksum(dict_file_checksum, dict_files, settings);
-    bool rebuild_pack = true;
-    if (pack_table->Exists() && pack_table->Load()) {
-      rebuild_pack = pack_table->dict_file_checksum() != pack_file_checksum;
-    }
-    if (rebuild_pack) {
-      LOG(INFO) << "rebuilding pack '" << pack_name << "'";
-      if (!BuildTable(table_index, collector, &settings, dict_files,
-                      pack_file_checksum)) {
-        LOG(ERROR) << "failed to build pack: " << pack_name;
-      }
-    } else {
-      LOG(INFO) << "pack '" << pack_name << "' reuses up-to-date table '"
-                << pack_table->file_path() << "'";
-    }
-    syllabary = std::move(collector.syllabary);
-    pack_table->Close();
+    packs_built.push_back(RunAsync(
+        [this, table_index, &syllabary, dict_file_checksum] {
+          BuildPack(table_index, syllabary, dict_file_checksum);
+        },
+        parallel));
+  }
+  for (auto& pack_built : packs_built) {
+    pack_built.wait();
   }
   // done!
   return true;
 }
 
+void DictCompiler::BuildPack(int table_index,
+                             const Syllabary& syllabary,
+                             uint32_t dict_file_checksum) {
+  const auto& pack_name = packs_[table_index - 1];
+  auto pack_table = tables_[table_index];
+  // a pack collects its entries against a copy of the primary syllabary.
+  EntryCollector collector{Syllabary(syllabary)};
+  DictSettings settings;
+  auto dict_file = source_resolver_->ResolvePath(pack_name + ".dict.yaml");
+  if (!std::filesystem::exists(dict_file)) {
+    if (pack_table->Exists())
+      LOG(INFO) << "pack source file '" << dict_file
+                << "' does not exist, using prebuilt table '"
+                << pack_table->file_path() << "'";
+    else
+      LOG(ERROR) << "neither pack source file '" << dict_file
+                 << "' nor a prebuilt table exists";
+    return;
+  }
+  if (!load_dict_settings_from_file(&settings, dict_file)) {
+    LOG(ERROR) << "failed to load settings from '" << dict_file << "'.";
+    return;
+  }
+  vector<path> dict_files;
+  if (!get_dict_files_from_settings(&dict_files, settings,
+                                    source_resolver_.get())) {
+    return;
+  }
+  uint32_t pack_file_checksum =
+      compute_dict_file_checksum(dict_file_checksum, dict_files, settings);
+  bool rebuild_pack = true;
+  if (pack_table->Exists() && pack_table->Load()) {
+    rebuild_pack = pack_table->dict_file_checksum() != pack_file_checksum ||
+                   pack_table->outdated();
+  }
+  if (rebuild_pack) {
+    LOG(INFO) << "rebuilding pack '" << pack_name << "'";
+    if (!BuildTable(table_index, collector, &settings, dict_files,
+                    pack_file_checksum)) {
+      LOG(ERROR) << "failed to build pack: " << pack_name;
+    }
+  } else {
+    LOG(INFO) << "pack '" << pack_name << "' reuses up-to-date table '"
+              << pack_table->file_path() << "'";
+  }
+  pack_table->Close();
+}
+
 static path relocate_target(const path& source_path,
                             ResourceResolver* target_resolver) {
   auto resource_id = source_path.filename().u8string();
@@ -224,6 +243,8 @@ bool DictCompiler::BuildTable(int table_index,
   LOG(INFO) << "building table: " << target_path;
   table = New<Table>(target_path);
 
+  bool parallel = !(options_ & kSequential);
+  collector.parallel = parallel;
   collector.Configure(settings);
   collector.Collect(dict_files);
   if (options_ & kDump) {
@@ -232,7 +253,7 @@ bool DictCompiler::BuildTable(int table_index,
     collector.Dump(dump_path);
   }
   Vocabulary vocabulary;
-  // build .table.bin
+  // prepare vocabulary for .table.bin
   {
     map<string, SyllableId> syllable_to_id;
     SyllableId syllable_id = 0;
@@ -262,19 +283,29 @@ bool DictCompiler::BuildTable(int table_index,
     if (settings->sort_order() != "original") {
       vocabulary.SortHomophones();
     }
-    table->Remove();
-    if (!table->Build(collector.syllabary, vocabulary, collector.num_entries,
-                      dict_file_checksum) ||
-        !table->Save()) {
-      return false;
-    }
   }
-  // build reverse db for the primary table
-  if (table_index == 0 &&
-      !BuildReverseDb(settings, collector, vocabulary, dict_file_checksum)) {
+  // build reverse db for the primary table, alongside the table itself;
+  // both only read the vocabulary from now on, and settings are left to
+  // the reverse db.
+  bool compact = settings->compact_table();
+  std::future<bool> reverse_db_built;
+  if (table_index == 0) {
+    reverse_db_built = RunAsync(
+        [&] {
+          return BuildReverseDb(settings, collector, vocabulary,
+                                dict_file_checksum);
+        },
+        parallel);
+  }
+  table->Remove();
+  bool success = table->Build(collector.syllabary, vocabulary,
+                              collector.num_entries, dict_file_checksum,
+                              compact) &&
+                 table->Save();
+  if (reverse_db_built.valid() && !reverse_db_built.get()) {
     return false;
   }
-  return true;
+  return success;
 }
 
 bool DictCompiler::BuildReverseDb(DictSettings* settings,
@@ -9,6 +9,7 @@
 
 #include <rime_api.h>
 #include <rime/common.h>
+#include <rime/dict/vocabulary.h>
 
 namespace rime {
 
@@ -19,7 +20,6 @@ class ReverseDb;
 class DictSettings;
 class EditDistanceCorrector;
 class EntryCollector;
-class Vocabulary;
 class ResourceResolver;
 
 class DictCompiler {
@@ -29,6 +29,8 @@ class DictCompiler {
     kRebuildTable = 2,
     kRebuild = kRebuildPrism | kRebuildTable,
     kDump = 4,
+    // build everything on the calling thread
+    kSequential = 8,
   };
 
   RIME_DLL explicit DictCompiler(Dictionary* dictionary);
@@ -43,6 +45,9 @@ class DictCompiler {
                   DictSettings* settings,
                   const vector<path>& dict_files,
                   uint32_t dict_file_checksum);
+  void BuildPack(int table_index,
+                 const Syllabary& syllabary,
+                 uint32_t dict_file_checksum);
   bool BuildPrism(const path& schema_file,
                   uint32_t dict_file_checksum,
                   uint32_t schema_file_checksum);
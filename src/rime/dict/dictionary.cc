@@ -4,7 +4,10 @@
 //
 // 2011-07-05 GONG Chen <chen.sst@gmail.com>
 //
+#include <algorithm>
 #include <filesystem>
+#include <functional>
+#include <boost/functional/hash.hpp>
 #include <rime/algo/syllabifier.h>
 #include <rime/common.h>
 #include <rime/dict/dictionary.h>
@@ -21,9 +24,8 @@ namespace dictionary {
 struct Chunk {
   Table* table = nullptr;
   Code code;
-  const table::Entry* entries = nullptr;
-  size_t size = 0;
-  size_t cursor = 0;
+  // entries left to visit
+  TableAccessor entries;
   string remaining_code;  // for predictive queries
   size_t matching_code_size = 0;
   double credibility = 0.0;
@@ -32,15 +34,13 @@ struct Chunk {
   Chunk() = default;
   Chunk(Table* t,
         const Code& c,
-        const table::Entry* e,
+        const TableAccessor& e,
         size_t m,
         double cr = 0.0,
         double q = 0.0)
       : table(t),
         code(c),
         entries(e),
-        size(1),
-        cursor(0),
         matching_code_size(m),
         credibility(cr),
         quality_len(q) {}
@@ -53,11 +53,9 @@ struct Chunk {
         double q = 0.0)
       : table(t),
         code(a.index_code()),
-        entries(a.entry()),
-        size(a.remaining()),
-        cursor(0),
+        entries(a),
         remaining_code(r),
-        matching_code_size(a.index_code().size()),
+        matching_code_size(a.index_code_size()),
         credibility(cr),
         quality_len(q) {}
 
@@ -68,19 +66,39 @@ struct Chunk {
 
 struct QueryResult {
   vector<Chunk> chunks;
+  // indices of chunks with entries left, visited in the order of addition
+  // starting from unsorted_head until sorted, then kept as a binary heap
+  // with the chunk of the best head element on top.
+  vector<size_t> pending;
+  size_t unsorted_head = 0;
+  bool sorted = false;
 };
 
 bool compare_chunk_by_head_element(const Chunk& a, const Chunk& b) {
-  if (!a.entries || a.cursor >= a.size)
+  if (a.entries.exhausted())
     return false;
-  if (!b.entries || b.cursor >= b.size)
+  if (b.entries.exhausted())
     return true;
   if (a.is_exact_match() != b.is_exact_match())
     return a.is_exact_match() > b.is_exact_match();
   if (a.remaining_code.length() != b.remaining_code.length())
     return a.remaining_code.length() < b.remaining_code.length();
-  return a.credibility + a.entries[a.cursor].weight >
-         b.credibility + b.entries[b.cursor].weight;  // by weight desc
+  return a.credibility + a.entries.entry()->weight >
+         b.credibility + b.entries.entry()->weight;  // by weight desc
+}
+
+// heap ordering on chunk indices: the best head element goes on top.
+struct ChunkHeapCompare {
+  const vector<Chunk>& chunks;
+
+  bool operator()(size_t a, size_t b) const {
+    return compare_chunk_by_head_element(chunks[b], chunks[a]);
+  }
+};
+
+inline double entry_weight(const Chunk& chunk, const table::Entry& e) {
+  const double kS = 18.420680743952367;  // log(1e8)
+  return e.weight - kS + chunk.credibility;
 }
 
 struct CodeMatch {
@@ -104,14 +122,14 @@ CodeMatch match_extra_code(const table::Code* extra_code,
       return kFailed;
   }
   auto index = syll_graph.indices.find(current_pos);
-  if (index == syll_graph.indices.end())
+  if (!index)
     return kFailed;
   SyllableId current_syll_id = extra_code->at[depth];
-  auto spellings = index->second.find(current_syll_id);
-  if (spellings == index->second.end())
+  auto spellings = index->find(current_syll_id);
+  if (spellings == index->end())
     return kFailed;
   CodeMatch best_match = kFailed;
-  for (const SpellingProperties* props : spellings->second) {
+  for (const SpellingProperties* props : spellings->spellings) {
     CodeMatch match = match_extra_code(extra_code, depth + 1, syll_graph,
                                        props->end_pos, predict_word);
     if (!match.success)
@@ -128,40 +146,103 @@ DictEntryIterator::DictEntryIterator()
     : query_result_(New<dictionary::QueryResult>()) {}
 
 void DictEntryIterator::AddChunk(dictionary::Chunk&& chunk) {
-  query_result_->chunks.push_back(std::move(chunk));
-  entry_count_ += chunk.size;
+  auto& result = *query_result_;
+  size_t size = chunk.entries.remaining();
+  entry_count_ += size;
+  if (size == 0)
+    return;
+  has_entry_text_ = false;
+  result.chunks.push_back(std::move(chunk));
+  result.pending.push_back(result.chunks.size() - 1);
+  if (result.sorted) {
+    std::push_heap(result.pending.begin(), result.pending.end(),
+                   dictionary::ChunkHeapCompare{result.chunks});
+  }
 }
 
 void DictEntryIterator::Sort() {
-  auto& chunks = query_result_->chunks;
-  // partial-sort remaining chunks, move best match to chunk_index_
-  std::partial_sort(chunks.begin() + chunk_index_,
-                    chunks.begin() + chunk_index_ + 1, chunks.end(),
-                    dictionary::compare_chunk_by_head_element);
+  auto& result = *query_result_;
+  auto& pending = result.pending;
+  has_entry_text_ = false;
+  if (!result.sorted) {
+    pending.erase(pending.begin(), pending.begin() + result.unsorted_head);
+    result.unsorted_head = 0;
+    result.sorted = true;
+  }
+  // O(n); moves the chunk with the best head element to the top of heap
+  std::make_heap(pending.begin(), pending.end(),
+                 dictionary::ChunkHeapCompare{result.chunks});
+}
+
+dictionary::Chunk& DictEntryIterator::current_chunk() {
+  auto& result = *query_result_;
+  return result.chunks[result.pending[result.unsorted_head]];
+}
+
+void DictEntryIterator::PopChunk() {
+  auto& result = *query_result_;
+  if (!result.sorted) {
+    ++result.unsorted_head;
+    return;
+  }
+  std::pop_heap(result.pending.begin(), result.pending.end(),
+                dictionary::ChunkHeapCompare{result.chunks});
+  result.pending.pop_back();
 }
 
 void DictEntryIterator::AddFilter(DictEntryFilter filter) {
-  DictEntryFilterBinder::AddFilter(filter);
+  DictEntryFilterBinder::AddFilter(std::move(filter));
+  SkipFilteredEntries();
+}
+
+void DictEntryIterator::AddFilter(DictEntryViewFilter filter) {
+  DictEntryFilterBinder::AddFilter(std::move(filter));
+  SkipFilteredEntries();
+}
+
+void DictEntryIterator::SkipFilteredEntries() {
   // the introduced filter could invalidate the current or even all the
   // remaining entries
-  while (!exhausted() && !filter_(Peek())) {
+  while (!exhausted() && !PassesFilters()) {
     entry_.reset();
     FindNextEntry();
   }
 }
 
+bool DictEntryIterator::PassesFilters() {
+  // filters of materialized entries create the entry only if its view
+  // has passed.
+  return (!view_filter_ || view_filter_(PeekView())) &&
+         (!filter_ || filter_(Peek()));
+}
+
+DictEntryView DictEntryIterator::PeekView() {
+  const auto& chunk = current_chunk();
+  const auto& e = *chunk.entries.entry();
+  double weight = dictionary::entry_weight(chunk, e);
+  if (has_entry_text_) {
+    return {entry_text_, &chunk.code, weight};
+  }
+  // read in place if the table has a string pool
+  auto text = chunk.table->GetEntryTextView(e, &entry_text_);
+  has_entry_text_ = !chunk.table->has_string_pool();
+  return {text, &chunk.code, weight};
+}
+
 an<DictEntry> DictEntryIterator::Peek() {
   if (!entry_ && !exhausted()) {
     // get next entry from current chunk
-    const auto& chunk = query_result_->chunks[chunk_index_];
-    const auto& e = chunk.entries[chunk.cursor];
-    DLOG(INFO) << "creating temporary dict entry '"
-               << chunk.table->GetEntryText(e) << "'.";
+    const auto& chunk = current_chunk();
+    const auto& e = *chunk.entries.entry();
     entry_ = New<DictEntry>();
     entry_->code = chunk.code;
-    entry_->text = chunk.table->GetEntryText(e);
-    const double kS = 18.420680743952367;  // log(1e8)
-    entry_->weight = e.weight - kS + chunk.credibility;
+    if (has_entry_text_) {
+      entry_->text = entry_text_;
+    } else {
+      entry_->text = chunk.table->GetEntryTextView(e, &entry_text_);
+    }
+    DLOG(INFO) << "creating temporary dict entry '" << entry_->text << "'.";
+    entry_->weight = dictionary::entry_weight(chunk, e);
     entry_->quality_len = chunk.quality_len;
     if (!chunk.remaining_code.empty()) {
       entry_->comment = "~" + chunk.remaining_code;
@@ -178,15 +259,26 @@ bool DictEntryIterator::FindNextEntry() {
   if (exhausted()) {
     return false;
   }
-  auto& chunk = query_result_->chunks[chunk_index_];
-  if (++chunk.cursor >= chunk.size) {
-    ++chunk_index_;
+  auto& result = *query_result_;
+  auto& chunk = current_chunk();
+  has_entry_text_ = false;
+  if (!chunk.entries.Next()) {
+    PopChunk();
+  } else if (result.sorted) {
+    // the top chunk has a new head element; sift it into place.
+    // pop_heap() never compares the top element, so it is safe to call
+    // after the top element has changed.
+    dictionary::ChunkHeapCompare compare{result.chunks};
+    std::pop_heap(result.pending.begin(), result.pending.end(), compare);
+    std::push_heap(result.pending.begin(), result.pending.end(), compare);
   }
   if (exhausted()) {
     return false;
   }
-  // reorder chunks to move the one with the best entry to head
-  Sort();
+  if (!result.sorted) {
+    // reorder chunks to move the one with the best entry to head
+    Sort();
+  }
   return true;
 }
 
@@ -196,7 +288,7 @@ bool DictEntryIterator::Next() {
     if (!FindNextEntry()) {
       return false;
     }
-  } while (filter_ && !filter_(Peek()));
+  } while (!PassesFilters());
   return true;
 }
 
@@ -205,23 +297,44 @@ bool DictEntryIterator::Skip(size_t num_entries) {
   while (num_entries > 0) {
     if (exhausted())
       return false;
-    auto& chunk = query_result_->chunks[chunk_index_];
-    if (chunk.cursor + num_entries < chunk.size) {
-      chunk.cursor += num_entries;
+    auto& chunk = current_chunk();
+    has_entry_text_ = false;
+    size_t remaining = chunk.entries.remaining();
+    if (num_entries < remaining) {
+      // stays on top; FindNextEntry() will sift it into place
+      chunk.entries.Skip(num_entries);
       return true;
     }
-    num_entries -= (chunk.size - chunk.cursor);
-    ++chunk_index_;
+    num_entries -= remaining;
+    PopChunk();
   }
   return true;
 }
 
 bool DictEntryIterator::exhausted() const {
-  return chunk_index_ >= query_result_->chunks.size();
+  return query_result_->unsorted_head >= query_result_->pending.size();
 }
 
 // Dictionary members
 
+namespace dictionary {
+
+// graphs queried are expected to come from one syllable graph cache, whose
+// revisions tell them apart.
+struct QueryMemo {
+  // revision of the syllable graph queried
+  size_t revision = 0;
+  struct Entry {
+    size_t horizon = 0;
+    // by table
+    vector<TableQueryResult> results;
+  };
+  // by start position
+  map<size_t, Entry> entries;
+};
+
+}  // namespace dictionary
+
 Dictionary::Dictionary(string name,
                        vector<string> packs,
                        vector<of<Table>> tables,
@@ -229,26 +342,23 @@ Dictionary::Dictionary(string name,
     : name_(name),
       packs_(std::move(packs)),
       tables_(std::move(tables)),
-      prism_(std::move(prism)) {}
+      prism_(std::move(prism)),
+      memo_(new dictionary::QueryMemo) {}
 
 Dictionary::~Dictionary() {
   // should not close shared table and prism objects
 }
 
 static void lookup_table(Table* table,
+                         const TableQueryResult& result,
                          DictEntryCollector* collector,
                          const SyllableGraph& syllable_graph,
-                         size_t start_pos,
                          bool predict_word,
                          double initial_credibility) {
-  TableQueryResult result;
-  if (!table->Query(syllable_graph, start_pos, &result)) {
-    return;
-  }
   // copy result
-  for (auto& v : result) {
+  for (const auto& v : result) {
     size_t end_pos = v.first;
-    for (TableAccessor& a : v.second) {
+    for (TableAccessor a : v.second) {
       double cr = initial_credibility + a.credibility();
       double q = a.quality_len();
       if (a.extra_code()) {
@@ -257,9 +367,9 @@ static void lookup_table(Table* table,
               a.extra_code(), 0, syllable_graph, end_pos, predict_word);
           if (!match.success)
             continue;
-          size_t matching_code_size = a.index_code().size() + match.depth;
+          size_t matching_code_size = a.index_code_size() + match.depth;
           (*collector)[match.end_pos].AddChunk(
-              {table, a.code(), a.entry(), matching_code_size, cr, q});
+              {table, a.code(), a.CurrentEntry(), matching_code_size, cr, q});
         } while (a.Next());
       } else {
         (*collector)[end_pos].AddChunk({table, a, cr, q});
@@ -268,6 +378,71 @@ static void lookup_table(Table* table,
   }
 }
 
+vector<const vector<TableQueryResult>*> Dictionary::QueryTables(
+    const SyllableGraph& syllable_graph,
+    const vector<size_t>& start_positions) {
+  auto& memo = *memo_;
+  if (!syllable_graph.revision) {
+    // not built with a cache; there is no telling whether it has changed.
+    memo.entries.clear();
+    memo.revision = 0;
+  } else if (syllable_graph.revision != memo.revision) {
+    if (memo.revision &&
+        syllable_graph.previous_revision == memo.revision) {
+      // keep queries that depend only on edges before the edited part
+      for (auto it = memo.entries.begin(); it != memo.entries.end();) {
+        if (it->second.horizon < syllable_graph.stable_length)
+          ++it;
+        else
+          it = memo.entries.erase(it);
+      }
+    } else {
+      memo.entries.clear();
+    }
+    memo.revision = syllable_graph.revision;
+  }
+  vector<const vector<TableQueryResult>*> results;
+  // positions not queried yet, and where their results go
+  vector<size_t> new_positions;
+  vector<dictionary::QueryMemo::Entry*> new_entries;
+  for (size_t start_pos : start_positions) {
+    auto found = memo.entries.find(start_pos);
+    if (found == memo.entries.end()) {
+      found = memo.entries.emplace(start_pos, dictionary::QueryMemo::Entry())
+                  .first;
+      found->second.horizon = start_pos;
+      found->second.results.resize(tables_.size());
+      new_positions.push_back(start_pos);
+      new_entries.push_back(&found->second);
+    }
+    results.push_back(&found->second.results);
+  }
+  if (new_positions.empty()) {
+    return results;
+  }
+  vector<TableQueryResult*> table_results(new_entries.size());
+  for (size_t i = 0; i < tables_.size(); ++i) {
+    if (!tables_[i]->IsOpen())
+      continue;
+    for (size_t j = 0; j < new_entries.size(); ++j) {
+      table_results[j] = &new_entries[j]->results[i];
+    }
+    tables_[i]->Query(syllable_graph, new_positions, table_results);
+    for (auto entry : new_entries) {
+      entry->horizon = (std::max)(entry->horizon, entry->results[i].horizon());
+    }
+  }
+  return results;
+}
+
+// looks up the text in place rather than copying it to a string key;
+// boost::hash gives the same value for a string and its view.
+static bool is_blacklisted(const hash_set<string>& blacklist,
+                           std::string_view text) {
+  return blacklist.find(text, boost::hash<std::string_view>(),
+                        std::equal_to<>()) != blacklist.end();
+}
+
 an<DictEntryCollector> Dictionary::Lookup(const SyllableGraph& syllable_graph,
                                           size_t start_pos,
                                           const hash_set<string>* blacklist,
@@ -275,12 +450,22 @@ an<DictEntryCollector> Dictionary::Lookup(const SyllableGraph& syllable_graph,
                                           double initial_credibility) {
   if (!loaded())
     return nullptr;
+  return Collect(*QueryTables(syllable_graph, {start_pos}).front(),
+                 syllable_graph, blacklist, predict_word, initial_credibility);
+}
+
+an<DictEntryCollector> Dictionary::Collect(
+    const vector<TableQueryResult>& results,
+    const SyllableGraph& syllable_graph,
+    const hash_set<string>* blacklist,
+    bool predict_word,
+    double initial_credibility) {
   auto collector = New<DictEntryCollector>();
-  for (const auto& table : tables_) {
-    if (!table->IsOpen())
+  for (size_t i = 0; i < tables_.size(); ++i) {
+    if (!tables_[i]->IsOpen())
       continue;
-    lookup_table(table.get(), collector.get(), syllable_graph, start_pos,
-                 predict_word, initial_credibility);
+    lookup_table(tables_[i].get(), results[i], collector.get(),
+                 syllable_graph, predict_word, initial_credibility);
   }
   if (collector->empty())
     return nullptr;
@@ -288,14 +473,33 @@ an<DictEntryCollector> Dictionary::Lookup(const SyllableGraph& syllable_graph,
   for (auto& v : *collector) {
     v.second.Sort();
     if (blacklist && !blacklist->empty()) {
-      v.second.AddFilter([blacklist](an<DictEntry> entry) {
-        return entry && !blacklist->count(entry->text);
+      v.second.AddFilter([blacklist](const DictEntryView& entry) {
+        return !is_blacklisted(*blacklist, entry.text);
       });
     }
   }
   return collector;
 }
 
+DictEntryGraph Dictionary::LookupGraph(const SyllableGraph& syllable_graph,
+                                       const hash_set<string>* blacklist) {
+  DictEntryGraph result;
+  if (!loaded())
+    return result;
+  vector<size_t> start_positions;
+  for (const auto& x : syllable_graph.edges) {
+    start_positions.push_back(x.first);
+  }
+  auto results = QueryTables(syllable_graph, start_positions);
+  for (size_t k = 0; k < start_positions.size(); ++k) {
+    if (auto collector = Collect(*results[k], syllable_graph, blacklist,
+                                 false, 0.0)) {
+      result[start_positions[k]] = collector;
+    }
+  }
+  return result;
+}
+
 size_t Dictionary::LookupWords(DictEntryIterator* result,
                                const string& str_code,
                                bool predictive,
@@ -341,8 +545,8 @@ size_t Dictionary::LookupWords(DictEntryIterator* result,
     }
   }
   if (blacklist && !blacklist->empty()) {
-    result->AddFilter([blacklist](an<DictEntry> entry) {
-      return entry && !blacklist->count(entry->text);
+    result->AddFilter([blacklist](const DictEntryView& entry) {
+      return !is_blacklisted(*blacklist, entry.text);
     });
   }
   return keys.size();
@@ -376,6 +580,14 @@ bool Dictionary::Remove() {
   return true;
 }
 
+// tables and prisms are shared by dictionaries in different sessions;
+// each is locked on its own, so loading one does not block the others.
+template <class T>
+static bool LoadShared(const T& file) {
+  std::lock_guard<std::mutex> lock(file->load_mutex());
+  return file->IsOpen() || file->Load();
+}
+
 bool Dictionary::Load() {
   LOG(INFO) << "loading dictionary '" << name_ << "'.";
   if (tables_.empty()) {
@@ -384,17 +596,18 @@ bool Dictionary::Load() {
     return false;
   }
   auto& primary_table = tables_[0];
-  if (!primary_table || (!primary_table->IsOpen() && !primary_table->Load())) {
+  if (!primary_table || !LoadShared(primary_table)) {
     LOG(ERROR) << "Error loading table for dictionary '" << name_ << "'.";
     return false;
   }
-  if (!prism_ || (!prism_->IsOpen() && !prism_->Load())) {
+  if (!prism_ || !LoadShared(prism_)) {
     LOG(ERROR) << "Error loading prism for dictionary '" << name_ << "'.";
     return false;
   }
   // packs are optional
   for (int i = 1; i < tables_.size(); ++i) {
     const auto& table = tables_[i];
+    std::lock_guard<std::mutex> lock(table->load_mutex());
     if (!table->IsOpen() && table->Exists() && table->Load()) {
       LOG(INFO) << "loaded pack: " << packs_[i - 1];
     }
@@ -447,31 +660,33 @@ Dictionary* DictionaryComponent::Create(const Ticket& ticket) {
       }
     }
   }
-  return Create(std::move(dict_name), std::move(prism_name), std::move(packs));
+  return Create(std::move(dict_name), std::move(prism_name), std::move(packs),
+                LoadPolicyFromConfig(config,
+                                     ticket.name_space + "/load_policy"));
 }
 
-Dictionary* DictionaryComponent::Create(string dict_name,
-                                        string prism_name,
-                                        vector<string> packs) {
+Dictionary* DictionaryComponent::Create(
+    string dict_name,
+    string prism_name,
+    vector<string> packs,
+    const MappedFileLoadPolicy& load_policy) {
+  auto new_table = [&](const string& name) {
+    return [&, name] {
+      auto table = New<Table>(table_resource_resolver_->ResolvePath(name));
+      table->set_load_policy(load_policy);
+      return table;
+    };
+  };
   // obtain prism and primary table objects
-  auto primary_table = table_map_[dict_name].lock();
-  if (!primary_table) {
-    auto file_path = table_resource_resolver_->ResolvePath(dict_name);
-    table_map_[dict_name] = primary_table = New<Table>(file_path);
-  }
-  auto prism = prism_map_[prism_name].lock();
-  if (!prism) {
-    auto file_path = prism_resource_resolver_->ResolvePath(prism_name);
-    prism_map_[prism_name] = prism = New<Prism>(file_path);
-  }
+  auto primary_table = table_cache_.Get(dict_name, new_table(dict_name));
+  auto prism = prism_cache_.Get(prism_name, [&] {
+    auto prism = New<Prism>(prism_resource_resolver_->ResolvePath(prism_name));
+    prism->set_load_policy(load_policy);
+    return prism;
+  });
   vector<of<Table>> tables = {std::move(primary_table)};
   for (const auto& pack : packs) {
-    auto table = table_map_[pack].lock();
-    if (!table) {
-      auto file_path = table_resource_resolver_->ResolvePath(pack);
-      table_map_[pack] = table = New<Table>(file_path);
-    }
-    tables.push_back(std::move(table));
+    tables.push_back(table_cache_.Get(pack, new_table(pack)));
   }
   return new Dictionary(std::move(dict_name), std::move(packs),
                         std::move(tables), std::move(prism));
@@ -10,6 +10,7 @@
 #include <rime_api.h>
 #include <rime/common.h>
 #include <rime/component.h>
+#include <rime/resource_cache.h>
 #include <rime/dict/prism.h>
 #include <rime/dict/table.h>
 #include <rime/dict/vocabulary.h>
@@ -20,6 +21,7 @@ namespace dictionary {
 
 struct Chunk;
 struct QueryResult;
+struct QueryMemo;
 
 }  // namespace dictionary
 
@@ -35,6 +37,7 @@ class RIME_DLL DictEntryIterator : public DictEntryFilterBinder {
   void AddChunk(dictionary::Chunk&& chunk);
   void Sort();
   void AddFilter(DictEntryFilter filter) override;
+  void AddFilter(DictEntryViewFilter filter) override;
   an<DictEntry> Peek();
   bool Next();
   bool Skip(size_t num_entries);
@@ -45,13 +48,27 @@ class RIME_DLL DictEntryIterator : public DictEntryFilterBinder {
   bool FindNextEntry();
 
  private:
+  dictionary::Chunk& current_chunk();
+  void PopChunk();
+  // a view of the current entry for filters to test, without creating a
+  // DictEntry object.
+  DictEntryView PeekView();
+  bool PassesFilters();
+  // skips the current entries that do not pass a newly introduced filter.
+  void SkipFilteredEntries();
+
   an<dictionary::QueryResult> query_result_;
-  size_t chunk_index_ = 0;
   an<DictEntry> entry_ = nullptr;
+  // text of the current entry, decoded by PeekView() if the table has no
+  // string pool to read it in place.
+  string entry_text_;
+  bool has_entry_text_ = false;
   size_t entry_count_ = 0;
 };
 
 using DictEntryCollector = map<size_t, DictEntryIterator>;
+// lookup results of a syllable graph by start position.
+using DictEntryGraph = map<size_t, an<DictEntryCollector>>;
 
 class Config;
 class Schema;
@@ -77,6 +94,13 @@ class Dictionary : public Class<Dictionary, const Ticket&> {
       const hash_set<string>* blacklist = nullptr,
       bool predict_word = false,
       double initial_credibility = 0.0);
+  // looks up words at every vertex of the syllable graph, as for making
+  // sentences, querying each table in one traversal of the graph. table
+  // queries are shared with lookups of the graph before it was last edited,
+  // where the edit does not reach them.
+  RIME_DLL DictEntryGraph LookupGraph(
+      const SyllableGraph& syllable_graph,
+      const hash_set<string>* blacklist = nullptr);
   // if predictive is true, do an expand search with limit,
   // otherwise do an exact match.
   // return num of matching keys.
@@ -97,10 +121,22 @@ class Dictionary : public Class<Dictionary, const Ticket&> {
   const an<Prism>& prism() const { return prism_; }
 
  private:
+  // results by table, for each of the start positions.
+  vector<const vector<TableQueryResult>*> QueryTables(
+      const SyllableGraph& syllable_graph,
+      const vector<size_t>& start_positions);
+  an<DictEntryCollector> Collect(const vector<TableQueryResult>& results,
+                                 const SyllableGraph& syllable_graph,
+                                 const hash_set<string>* blacklist,
+                                 bool predict_word,
+                                 double initial_credibility);
+
   string name_;
   vector<string> packs_;
   vector<of<Table>> tables_;
   an<Prism> prism_;
+  // table queries of the syllable graph last looked up
+  the<dictionary::QueryMemo> memo_;
 };
 
 class ResourceResolver;
@@ -110,11 +146,18 @@ class DictionaryComponent : public Dictionary::Component {
   DictionaryComponent();
   ~DictionaryComponent() override;
   Dictionary* Create(const Ticket& ticket) override;
-  Dictionary* Create(string dict_name, string prism_name, vector<string> packs);
+  Dictionary* Create(string dict_name,
+                     string prism_name,
+                     vector<string> packs,
+                     const MappedFileLoadPolicy& load_policy = {});
+
+  ResourceCacheStats prism_cache_stats() { return prism_cache_.stats(); }
+  ResourceCacheStats table_cache_stats() { return table_cache_.stats(); }
 
  private:
-  map<string, weak<Prism>> prism_map_;
-  map<string, weak<Table>> table_map_;
+  // shared by sessions on different threads
+  ResourceCache<Prism> prism_cache_{SizeOfFile<Prism>};
+  ResourceCache<Table> table_cache_{SizeOfFile<Table>};
   the<ResourceResolver> prism_resource_resolver_;
   the<ResourceResolver> table_resource_resolver_;
 };
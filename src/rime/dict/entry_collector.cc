@@ -9,12 +9,26 @@
 #include <utility>
 #include <boost/algorithm/string.hpp>
 #include <rime/algo/strings.h>
+#include <rime/algo/utilities.h>
 #include <rime/dict/dict_settings.h>
 #include <rime/dict/entry_collector.h>
 #include <rime/dict/preset_vocabulary.h>
 
 namespace rime {
 
+struct DictFileRow {
+  size_t line_number;
+  string word;
+  string code;
+  string weight;
+  string stem;
+};
+
+struct DictFileRows {
+  string file_name;
+  vector<DictFileRow> rows;
+};
+
 EntryCollector::EntryCollector() {}
 
 EntryCollector::EntryCollector(Syllabary&& fixed_syllabary)
@@ -36,8 +50,15 @@ void EntryCollector::Configure(DictSettings* settings) {
 }
 
 void EntryCollector::Collect(const vector<path>& dict_files) {
+  // read files in parallel, but collect their rows in the given order so
+  // that the built tables are the same as if they were read one by one.
+  vector<std::future<DictFileRows>> reading;
   for (const path& dict_file : dict_files) {
-    Collect(dict_file);
+    reading.push_back(
+        RunAsync([dict_file] { return ReadDictFile(dict_file); }, parallel));
+  }
+  for (auto& dict_file : reading) {
+    Collect(dict_file.get());
   }
   Finish();
 }
@@ -54,16 +75,15 @@ void EntryCollector::LoadPresetVocabulary(DictSettings* settings) {
   }
 }
 
-void EntryCollector::Collect(const path& dict_file) {
-  LOG(INFO) << "collecting entries from " << dict_file;
-  current_dict_file = dict_file.u8string();
-  line_number = 0;
+DictFileRows EntryCollector::ReadDictFile(const path& dict_file) {
+  LOG(INFO) << "reading entries from " << dict_file;
+  DictFileRows result{dict_file.u8string()};
   // read table
   std::ifstream fin(dict_file.c_str());
   DictSettings settings;
   if (!settings.LoadDictHeader(fin)) {
     LOG(ERROR) << "missing dict settings.";
-    return;
+    return result;
   }
   // column definitions
   int text_column = settings.GetColumnIndex("text");
@@ -73,9 +93,10 @@ void EntryCollector::Collect(const path& dict_file) {
   if (text_column == -1) {
     LOG(ERROR) << "missing text column definition in file: " << dict_file
                << ".";
-    return;
+    return result;
   }
   bool enable_comment = true;
+  size_t line_number = 0;
   string line;
   while (getline(fin, line)) {
     boost::algorithm::trim_right(line);
@@ -90,42 +111,52 @@ void EntryCollector::Collect(const path& dict_file) {
       }
       continue;
     }
+    if (!strings::utf8_valid(line)) {
+      LOG(WARNING) << "Invalid UTF-8 at line: " << line_number
+                   << " of file: " << result.file_name << ".";
+      continue;
+    }
     // read a dict entry
     auto row = strings::split(line, "\t");
     int num_columns = static_cast<int>(row.size());
     if (num_columns <= text_column || row[text_column].empty()) {
-      LOG(WARNING) << "Missing entry text at #" << num_entries
-                   << ", line: " << line_number
-                   << " of file: " << current_dict_file << ".";
+      LOG(WARNING) << "Missing entry text at line: " << line_number
+                   << " of file: " << result.file_name << ".";
       continue;
     }
-    const auto& word(row[text_column]);
-    string code_str;
-    string weight_str;
-    string stem_str;
-    if (code_column != -1 && num_columns > code_column &&
-        !row[code_column].empty())
-      code_str = row[code_column];
-    if (weight_column != -1 && num_columns > weight_column &&
-        !row[weight_column].empty())
-      weight_str = row[weight_column];
-    if (stem_column != -1 && num_columns > stem_column &&
-        !row[stem_column].empty())
-      stem_str = row[stem_column];
+    DictFileRow entry{line_number, std::move(row[text_column])};
+    if (code_column != -1 && num_columns > code_column)
+      entry.code = std::move(row[code_column]);
+    if (weight_column != -1 && num_columns > weight_column)
+      entry.weight = std::move(row[weight_column]);
+    if (stem_column != -1 && num_columns > stem_column)
+      entry.stem = std::move(row[stem_column]);
+    result.rows.push_back(std::move(entry));
+  }
+  fin.close();
+  return result;
+}
+
+void EntryCollector::Collect(const DictFileRows& dict_file) {
+  LOG(INFO) << "collecting entries from " << dict_file.file_name;
+  current_dict_file = dict_file.file_name;
+  line_number = 0;
+  for (const auto& row : dict_file.rows) {
+    line_number = row.line_number;
+    const auto& word(row.word);
     // collect entry
     collection.insert(word);
-    if (!code_str.empty()) {
-      CreateEntry(word, code_str, weight_str);
+    if (!row.code.empty()) {
+      CreateEntry(word, row.code, row.weight);
     } else {
-      encode_queue.push({word, weight_str});
+      encode_queue.push({word, row.weight});
     }
-    if (!stem_str.empty() && !code_str.empty()) {
+    if (!row.stem.empty() && !row.code.empty()) {
       DLOG(INFO) << "add stem '" << word << "': "
-                 << "[" << code_str << "] = [" << stem_str << "]";
-      stems[word].insert(stem_str);
+                 << "[" << row.code << "] = [" << row.stem << "]";
+      stems[word].insert(row.stem);
     }
   }
-  fin.close();
   LOG(INFO) << "Pass 1: total " << num_entries << " entries collected.";
   LOG(INFO) << "num unique syllables: " << syllabary.size();
   LOG(INFO) << "num of entries to encode: " << encode_queue.size();
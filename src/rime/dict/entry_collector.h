@@ -32,11 +32,14 @@ using EncodeQueue = std::queue<pair<string, string>>;
 
 class PresetVocabulary;
 class DictSettings;
+struct DictFileRows;
 
 class EntryCollector : public PhraseCollector {
  public:
   Syllabary syllabary;
   bool build_syllabary = true;
+  // whether to read dict files on multiple threads
+  bool parallel = true;
   vector<of<RawDictEntry>> entries;
   size_t num_entries = 0;
   ReverseLookupTable stems;
@@ -59,8 +62,10 @@ class EntryCollector : public PhraseCollector {
 
  protected:
   void LoadPresetVocabulary(DictSettings* settings);
+  // reads the entry rows of a dict file; safe to call on any thread.
+  static DictFileRows ReadDictFile(const path& dict_file);
   // call Collect() multiple times for all required tables
-  void Collect(const path& dict_file);
+  void Collect(const DictFileRows& dict_file);
   // encode all collected entries
   void Finish();
 
@@ -5,9 +5,13 @@
 // 2014-12-04 Chen Gong <chen.sst@gmail.com>
 //
 
+#include <mutex>
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 #include <leveldb/write_batch.h>
 #include <rime/common.h>
+#include <rime/config.h>
 #include <rime/service.h>
 #include <rime/dict/level_db.h>
 #include <rime/dict/user_db.h>
@@ -16,12 +20,102 @@ namespace rime {
 
 static const char* kMetaCharacter = "\x01";
 
+LevelDbOptions LoadLevelDbOptions(const string& db_type) {
+  auto component = Config::Require("config");
+  if (!component || db_type.empty())
+    return LevelDbOptions();
+  the<Config> config(component->Create("default"));
+  return LoadLevelDbOptions(config.get(), db_type);
+}
+
+LevelDbOptions LoadLevelDbOptions(Config* config, const string& db_type) {
+  LevelDbOptions options;
+  if (!config || db_type.empty())
+    return options;
+  const string prefix = "db_options/" + db_type + "/";
+  int megabytes = 0;
+  if (config->GetInt(prefix + "block_cache_size", &megabytes) &&
+      megabytes > 0) {
+    options.block_cache_size = size_t(megabytes) << 20;
+  }
+  megabytes = 0;
+  if (config->GetInt(prefix + "write_buffer_size", &megabytes) &&
+      megabytes > 0) {
+    options.write_buffer_size = size_t(megabytes) << 20;
+  }
+  config->GetInt(prefix + "bloom_filter_bits", &options.bloom_filter_bits);
+  config->GetBool(prefix + "compression", &options.compression);
+  config->GetBool(prefix + "fill_cache", &options.fill_cache);
+  return options;
+}
+
+// leveldb objects made from the options, shared by dbs of a class.
+struct LevelDbResources {
+  LevelDbOptions options;
+  the<leveldb::Cache> block_cache;
+  the<const leveldb::FilterPolicy> filter_policy;
+
+  explicit LevelDbResources(const LevelDbOptions& options) : options(options) {
+    if (options.block_cache_size > 0) {
+      block_cache.reset(leveldb::NewLRUCache(options.block_cache_size));
+    }
+    if (options.bloom_filter_bits > 0) {
+      filter_policy.reset(
+          leveldb::NewBloomFilterPolicy(options.bloom_filter_bits));
+    }
+  }
+
+  leveldb::Options MakeOptions() const {
+    leveldb::Options result;
+    result.block_cache = block_cache.get();
+    result.filter_policy = filter_policy.get();
+    if (options.write_buffer_size > 0) {
+      result.write_buffer_size = options.write_buffer_size;
+    }
+    result.compression = options.compression ? leveldb::kSnappyCompression
+                                             : leveldb::kNoCompression;
+    return result;
+  }
+
+  // the resources of a db class live as long as any db of the class is open.
+  static an<LevelDbResources> ForClass(const string& db_type) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    static map<string, weak<LevelDbResources>> classes;
+    auto resources = classes[db_type].lock();
+    if (!resources) {
+      auto preset = class_options().find(db_type);
+      resources = New<LevelDbResources>(preset != class_options().end()
+                                            ? preset->second
+                                            : LoadLevelDbOptions(db_type));
+      classes[db_type] = resources;
+    }
+    return resources;
+  }
+
+  static void SetClassOptions(const string& db_type,
+                              const LevelDbOptions& options) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    class_options()[db_type] = options;
+  }
+
+ private:
+  static std::mutex& registry_mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static map<string, LevelDbOptions>& class_options() {
+    static map<string, LevelDbOptions> options;
+    return options;
+  }
+};
+
 struct LevelDbCursor {
   leveldb::Iterator* iterator = nullptr;
 
-  LevelDbCursor(leveldb::DB* db) {
+  LevelDbCursor(leveldb::DB* db, bool fill_cache) {
     leveldb::ReadOptions options;
-    options.fill_cache = false;
+    options.fill_cache = fill_cache;
     iterator = db->NewIterator(options);
   }
 
@@ -49,10 +143,16 @@ struct LevelDbCursor {
 
 struct LevelDbWrapper {
   leveldb::DB* ptr = nullptr;
+  an<LevelDbResources> resources;
+  // the db is shared by sessions, which may write from different threads.
+  std::mutex batch_mutex;
   leveldb::WriteBatch batch;
 
-  leveldb::Status Open(const path& file_path, bool readonly) {
-    leveldb::Options options;
+  leveldb::Status Open(const path& file_path,
+                       bool readonly,
+                       an<LevelDbResources> db_resources) {
+    resources = db_resources;
+    leveldb::Options options = resources->MakeOptions();
     options.create_if_missing = !readonly;
     return leveldb::DB::Open(options, file_path.string(), &ptr);
   }
@@ -60,9 +160,24 @@ struct LevelDbWrapper {
   void Release() {
     delete ptr;
     ptr = nullptr;
+    // after the db that uses them
+    resources.reset();
+  }
+
+  LevelDbCursor* CreateCursor() {
+    return new LevelDbCursor(ptr, resources->options.fill_cache);
   }
 
-  LevelDbCursor* CreateCursor() { return new LevelDbCursor(ptr); }
+  size_t ApproximateMemoryUsage() {
+    string value;
+    if (!ptr || !ptr->GetProperty("leveldb.approximate-memory-usage", &value))
+      return 0;
+    try {
+      return std::stoul(value);
+    } catch (...) {
+      return 0;
+    }
+  }
 
   bool Fetch(const string& key, string* value) {
     auto status = ptr->Get(leveldb::ReadOptions(), key, value);
@@ -71,6 +186,7 @@ struct LevelDbWrapper {
 
   bool Update(const string& key, const string& value, bool write_batch) {
     if (write_batch) {
+      std::lock_guard<std::mutex> lock(batch_mutex);
       batch.Put(key, value);
       return true;
     }
@@ -80,6 +196,7 @@ struct LevelDbWrapper {
 
   bool Erase(const string& key, bool write_batch) {
     if (write_batch) {
+      std::lock_guard<std::mutex> lock(batch_mutex);
       batch.Delete(key);
       return true;
     }
@@ -87,9 +204,13 @@ struct LevelDbWrapper {
     return status.ok();
   }
 
-  void ClearBatch() { batch.Clear(); }
+  void ClearBatch() {
+    std::lock_guard<std::mutex> lock(batch_mutex);
+    batch.Clear();
+  }
 
   bool CommitBatch() {
+    std::lock_guard<std::mutex> lock(batch_mutex);
     auto status = ptr->Write(leveldb::WriteOptions(), &batch);
     return status.ok();
   }
@@ -153,6 +274,34 @@ void LevelDb::Initialize() {
   db_.reset(new LevelDbWrapper);
 }
 
+an<LevelDbResources> LevelDb::resources() const {
+  return options_ ? New<LevelDbResources>(*options_)
+                  : LevelDbResources::ForClass(db_type_);
+}
+
+void LevelDb::set_options(const LevelDbOptions& options) {
+  options_.reset(new LevelDbOptions(options));
+}
+
+void LevelDb::set_class_options(const string& db_type,
+                                const LevelDbOptions& options) {
+  LevelDbResources::SetClassOptions(db_type, options);
+}
+
+size_t LevelDb::ApproximateMemoryUsage() {
+  return loaded() ? db_->ApproximateMemoryUsage() : 0;
+}
+
+const leveldb::Cache* LevelDb::block_cache() const {
+  return loaded() && db_->resources ? db_->resources->block_cache.get()
+                                    : nullptr;
+}
+
+const leveldb::FilterPolicy* LevelDb::filter_policy() const {
+  return loaded() && db_->resources ? db_->resources->filter_policy.get()
+                                    : nullptr;
+}
+
 an<DbAccessor> LevelDb::QueryMetadata() {
   return Query(kMetaCharacter);
 }
@@ -244,7 +393,7 @@ bool LevelDb::Open() {
     return false;
   Initialize();
   readonly_ = false;
-  auto status = db_->Open(file_path(), readonly_);
+  auto status = db_->Open(file_path(), readonly_, resources());
   loaded_ = status.ok();
 
   if (loaded_) {
@@ -266,7 +415,7 @@ bool LevelDb::OpenReadOnly() {
     return false;
   Initialize();
   readonly_ = true;
-  auto status = db_->Open(file_path(), readonly_);
+  auto status = db_->Open(file_path(), readonly_, resources());
   loaded_ = status.ok();
 
   if (!loaded_) {
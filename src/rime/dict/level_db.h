@@ -7,12 +7,41 @@
 #ifndef RIME_LEVEL_DB_H_
 #define RIME_LEVEL_DB_H_
 
+#include <rime_api.h>
 #include <rime/dict/db.h>
 
+namespace leveldb {
+class Cache;
+class FilterPolicy;
+}  // namespace leveldb
+
 namespace rime {
 
+class Config;
 struct LevelDbCursor;
 struct LevelDbWrapper;
+struct LevelDbResources;
+
+// options to tune leveldb for a class of dbs.
+struct LevelDbOptions {
+  // size in bytes of the block cache shared by dbs of the class;
+  // 0 for leveldb's default cache for each db.
+  size_t block_cache_size = 0;
+  // bits per key of bloom filters; 0 for no filter.
+  int bloom_filter_bits = 0;
+  // size in bytes of the memtable; 0 for leveldb's default.
+  size_t write_buffer_size = 0;
+  bool compression = true;
+  // whether data read by scans is kept in the block cache.
+  bool fill_cache = false;
+};
+
+// reads options of a class of dbs from default.yaml, under
+// db_options/<db_type>, with cache and buffer sizes in megabytes.
+RIME_DLL LevelDbOptions LoadLevelDbOptions(const string& db_type);
+// reads them from the given config instead; unset options keep defaults.
+RIME_DLL LevelDbOptions LoadLevelDbOptions(Config* config,
+                                           const string& db_type);
 
 class LevelDb;
 
@@ -62,15 +91,32 @@ class LevelDb : public Db, public Recoverable, public Transactional {
   bool Recover() override;
 
   // Transactional
+  // a single transaction spans all writers of the db; user dictionaries
+  // keep their own and write through UserDbCache one at a time.
   bool BeginTransaction() override;
   bool AbortTransaction() override;
   bool CommitTransaction() override;
 
+  // opens the db with the given options instead of those of its class,
+  // not sharing the block cache.
+  RIME_DLL void set_options(const LevelDbOptions& options);
+  // sets options of a class of dbs in place of those in default.yaml;
+  // takes effect when no db of the class is open.
+  RIME_DLL static void set_class_options(const string& db_type,
+                                         const LevelDbOptions& options);
+  // memtables and block cache, including the share of other dbs.
+  RIME_DLL size_t ApproximateMemoryUsage();
+  // what the db is opened with; null if it's closed or goes without one.
+  RIME_DLL const leveldb::Cache* block_cache() const;
+  RIME_DLL const leveldb::FilterPolicy* filter_policy() const;
+
  private:
   void Initialize();
+  an<LevelDbResources> resources() const;
 
   the<LevelDbWrapper> db_;
   string db_type_;
+  the<LevelDbOptions> options_;
 };
 
 }  // namespace rime
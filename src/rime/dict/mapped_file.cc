@@ -10,8 +10,13 @@
 #include <filesystem>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
+#include <rime/config.h>
 #include <rime/dict/mapped_file.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 namespace rime {
 
 class MappedFileImpl {
@@ -21,14 +26,41 @@ class MappedFileImpl {
     kOpenReadWrite,
   };
 
-  MappedFileImpl(const path& file_path, OpenMode mode) {
+  MappedFileImpl(const path& file_path,
+                 OpenMode mode,
+                 const MappedFileLoadPolicy& policy = {}) {
+    using boost::interprocess::mapped_region;
     boost::interprocess::mode_t file_mapping_mode =
         (mode == kOpenReadOnly) ? boost::interprocess::read_only
                                 : boost::interprocess::read_write;
     file_.reset(new boost::interprocess::file_mapping(file_path.c_str(),
                                                       file_mapping_mode));
-    region_.reset(
-        new boost::interprocess::mapped_region(*file_, file_mapping_mode));
+    boost::interprocess::map_options_t map_options =
+        boost::interprocess::default_map_options;
+#ifdef MAP_POPULATE
+    if (policy.populate) {
+      map_options = MAP_POPULATE;
+    }
+#endif
+    region_.reset(new mapped_region(*file_, file_mapping_mode, 0, 0, nullptr,
+                                    map_options));
+    if (policy.random_access) {
+      region_->advise(mapped_region::advice_random);
+    }
+    if (policy.prefetch) {
+      region_->advise(mapped_region::advice_willneed);
+    }
+#ifdef MADV_HUGEPAGE
+    if (policy.huge_pages &&
+        madvise(get_address(), get_size(), MADV_HUGEPAGE) != 0) {
+      LOG(WARNING) << "huge pages are not available for " << file_path;
+    }
+#endif
+#ifndef _WIN32
+    if (policy.lock && mlock(get_address(), get_size()) != 0) {
+      LOG(WARNING) << "failed to lock " << file_path << " in memory.";
+    }
+#endif
   }
   ~MappedFileImpl() {
     region_.reset();
@@ -43,6 +75,18 @@ class MappedFileImpl {
   the<boost::interprocess::mapped_region> region_;
 };
 
+MappedFileLoadPolicy LoadPolicyFromConfig(Config* config, const string& key) {
+  MappedFileLoadPolicy policy;
+  if (config) {
+    config->GetBool(key + "/prefetch", &policy.prefetch);
+    config->GetBool(key + "/random_access", &policy.random_access);
+    config->GetBool(key + "/populate", &policy.populate);
+    config->GetBool(key + "/lock", &policy.lock);
+    config->GetBool(key + "/huge_pages", &policy.huge_pages);
+  }
+  return policy;
+}
+
 MappedFile::MappedFile(const path& file_path) : file_path_(file_path) {}
 
 MappedFile::~MappedFile() {
@@ -78,7 +122,8 @@ bool MappedFile::OpenReadOnly() {
     LOG(ERROR) << "attempt to open non-existent file '" << file_path_ << "'.";
     return false;
   }
-  file_.reset(new MappedFileImpl(file_path_, MappedFileImpl::kOpenReadOnly));
+  file_.reset(new MappedFileImpl(file_path_, MappedFileImpl::kOpenReadOnly,
+                                 load_policy_));
   size_ = file_->get_size();
   return bool(file_);
 }
@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <cstring>
+#include <mutex>
 #include <rime_api.h>
 #include <rime/common.h>
 
@@ -76,6 +77,27 @@ struct List {
   const T* end() const { return &at[0] + size; }
 };
 
+// hints to the OS on how a file mapped for reading is going to be accessed
+
+struct MappedFileLoadPolicy {
+  // read ahead the whole file once it is mapped
+  bool prefetch = false;
+  // expect random access; disables read-around on page faults
+  bool random_access = false;
+  // fault in all pages of the file when mapping it, where supported
+  bool populate = false;
+  // keep the mapped pages resident in memory
+  bool lock = false;
+  // back the mapping with transparent huge pages where available
+  bool huge_pages = false;
+};
+
+class Config;
+
+// reads a load policy from the config map at key, eg. translator/load_policy
+RIME_DLL MappedFileLoadPolicy LoadPolicyFromConfig(Config* config,
+                                                   const string& key);
+
 // MappedFile class definition
 
 class MappedFileImpl;
@@ -120,10 +142,21 @@ class RIME_DLL MappedFile {
   const path& file_path() const { return file_path_; }
   size_t file_size() const { return size_; }
 
+  // held while opening a file shared by dictionaries in different sessions.
+  std::mutex& load_mutex() const { return load_mutex_; }
+
+  // takes effect the next time the file is opened for reading.
+  const MappedFileLoadPolicy& load_policy() const { return load_policy_; }
+  void set_load_policy(const MappedFileLoadPolicy& policy) {
+    load_policy_ = policy;
+  }
+
  private:
   path file_path_;
   size_t size_ = 0;
+  MappedFileLoadPolicy load_policy_;
   the<MappedFileImpl> file_;
+  mutable std::mutex load_mutex_;
 };
 
 // member function definitions
@@ -4,9 +4,9 @@
 //
 // 2011-11-27 GONG Chen <chen.sst@gmail.com>
 //
-#include <utf8.h>
 #include <rime/resource.h>
 #include <rime/service.h>
+#include <rime/algo/strings.h>
 #include <rime/dict/preset_vocabulary.h>
 #include <rime/dict/text_db.h>
 
@@ -100,8 +100,7 @@ bool PresetVocabulary::GetNextEntry(string* key, string* value) {
 bool PresetVocabulary::IsQualifiedPhrase(const string& phrase,
                                          const string& weight_str) {
   if (max_phrase_length_ > 0) {
-    size_t length = utf8::unchecked::distance(phrase.c_str(),
-                                              phrase.c_str() + phrase.length());
+    size_t length = strings::utf8_length(phrase);
     if (static_cast<int>(length) > max_phrase_length_)
       return false;
   }
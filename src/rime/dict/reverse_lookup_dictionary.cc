@@ -240,8 +240,13 @@ ReverseLookupDictionaryComponent::ReverseLookupDictionaryComponent()
               kReverseDbResourceType))) {}
 
 ReverseLookupDictionary* ReverseLookupDictionaryComponent::Create(
-    const string& dict_name) {
+    const string& dict_name,
+    const MappedFileLoadPolicy& load_policy) {
   auto db = GetDb(dict_name);
+  // the db may be shared and already loaded
+  if (db && !db->IsOpen()) {
+    db->set_load_policy(load_policy);
+  }
   return new ReverseLookupDictionary(db);
 };
 
@@ -255,7 +260,9 @@ ReverseLookupDictionary* ReverseLookupDictionaryComponent::Create(
     // missing!
     return NULL;
   }
-  return Create(dict_name);
+  return Create(dict_name,
+                LoadPolicyFromConfig(config,
+                                     ticket.name_space + "/load_policy"));
 }
 
 }  // namespace rime
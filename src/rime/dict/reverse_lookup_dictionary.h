@@ -80,8 +80,11 @@ class ReverseLookupDictionaryComponent
       protected DbPool<ReverseDb> {
  public:
   ReverseLookupDictionaryComponent();
+  using DbPool<ReverseDb>::db_cache_stats;
   ReverseLookupDictionary* Create(const Ticket& ticket);
-  ReverseLookupDictionary* Create(const string& dict_name);
+  ReverseLookupDictionary* Create(
+      const string& dict_name,
+      const MappedFileLoadPolicy& load_policy = {});
 };
 
 }  // namespace rime
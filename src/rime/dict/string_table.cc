@@ -62,6 +62,20 @@ string StringTable::GetString(StringId string_id) {
   return string(agent.key().ptr(), agent.key().length());
 }
 
+bool StringTable::GetString(StringId string_id, string* result) {
+  marisa::Agent agent;
+  agent.set_query(string_id);
+  try {
+    trie_.reverse_lookup(agent);
+  } catch (const marisa::Exception& /*ex*/) {
+    LOG(ERROR) << "invalid id for string table: " << string_id;
+    result->clear();
+    return false;
+  }
+  result->assign(agent.key().ptr(), agent.key().length());
+  return true;
+}
+
 size_t StringTable::NumKeys() const {
   return trie_.size();
 }
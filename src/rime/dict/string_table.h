@@ -31,6 +31,8 @@ class RIME_DLL StringTable {
   void CommonPrefixMatch(const string& query, vector<StringId>* result);
   void Predict(const string& query, vector<StringId>* result);
   string GetString(StringId string_id);
+  // same as above but reuses the storage of result.
+  bool GetString(StringId string_id, string* result);
 
   size_t NumKeys() const;
   size_t BinarySize() const;
@@ -5,9 +5,9 @@
 // 2011-07-02 GONG Chen <chen.sst@gmail.com>
 //
 #include <cfloat>
+#include <cmath>
 #include <cstring>
 #include <algorithm>
-#include <queue>
 #include <utility>
 #include <rime/common.h>
 #include <rime/algo/syllabifier.h>
@@ -15,51 +15,125 @@
 
 namespace rime {
 
-const char kTableFormatLatest[] = "Rime::Table/4.0";
+const char kTableFormatLatest[] = "Rime::Table/5.0";
+const double kTableFormatVersion = 5.0;
 const int kTableFormatLowestCompatible = 4.0;
+// v5.0 adds hash tables of trunk index keys, and optionally packed entries,
+// which readers of v4 would misread; they are refused by the next major.
+const double kTableFormatHashedTrunk = 5.0;
+const double kTableFormatIncompatible = 6.0;
+
+// packed weights are rounded to multiples of 1 / kPackedWeightScale
+const double kPackedWeightScale = 1024.0;
 
 const char kTableFormatPrefix[] = "Rime::Table/";
 const size_t kTableFormatPrefixLen = sizeof(kTableFormatPrefix) - 1;
 
-TableAccessor::TableAccessor(const Code& index_code,
+TableAccessor::TableAccessor(const SyllableId* index_code,
+                             size_t index_code_size,
                              const List<table::Entry>* list,
                              double credibility,
                              double quality_len)
-    : index_code_(index_code),
-      entries_(list->at.get()),
+    : entries_(list->at.get()),
       size_(list->size),
       credibility_(credibility),
-      quality_len_(quality_len) {}
+      quality_len_(quality_len) {
+  SetIndexCode(index_code, index_code_size);
+}
 
-TableAccessor::TableAccessor(const Code& index_code,
+TableAccessor::TableAccessor(const SyllableId* index_code,
+                             size_t index_code_size,
                              const Array<table::Entry>* array,
                              double credibility,
                              double quality_len)
-    : index_code_(index_code),
-      entries_(array->at),
+    : entries_(array->at),
       size_(array->size),
       credibility_(credibility),
-      quality_len_(quality_len) {}
+      quality_len_(quality_len) {
+  SetIndexCode(index_code, index_code_size);
+}
+
+TableAccessor::TableAccessor(const SyllableId* index_code,
+                             size_t index_code_size,
+                             const table::PackedEntryList* packed_list,
+                             double credibility,
+                             double quality_len)
+    : packed_entries_(packed_list->at.get()),
+      size_(packed_list->size),
+      credibility_(credibility),
+      quality_len_(quality_len) {
+  SetIndexCode(index_code, index_code_size);
+  if (packed_entries_ && size_ > 0) {
+    UnpackEntry();
+  }
+}
 
-TableAccessor::TableAccessor(const Code& index_code,
+TableAccessor::TableAccessor(const SyllableId* index_code,
+                             size_t index_code_size,
                              const table::TailIndex* code_map,
                              double credibility,
                              double quality_len)
-    : index_code_(index_code),
-      long_entries_(code_map->at),
+    : long_entries_(code_map->at),
       size_(code_map->size),
       credibility_(credibility),
-      quality_len_(quality_len) {}
+      quality_len_(quality_len) {
+  SetIndexCode(index_code, index_code_size);
+}
+
+void TableAccessor::SetIndexCode(const SyllableId* index_code,
+                                 size_t index_code_size) {
+  index_code_size_ = (std::min)(index_code_size, Code::kIndexCodeMaxLength);
+  std::copy(index_code, index_code + index_code_size_, index_code_);
+}
+
+// zigzag encoding maps signed integers of small magnitude to small varints.
+inline static uint32_t zigzag_encode(int32_t n) {
+  return (static_cast<uint32_t>(n) << 1) ^ static_cast<uint32_t>(n >> 31);
+}
+
+inline static int32_t zigzag_decode(uint32_t n) {
+  return static_cast<int32_t>(n >> 1) ^ -static_cast<int32_t>(n & 1);
+}
+
+static void pack_varint(uint32_t n, vector<uint8_t>* packed) {
+  while (n >= 0x80) {
+    packed->push_back(static_cast<uint8_t>(n) | 0x80);
+    n >>= 7;
+  }
+  packed->push_back(static_cast<uint8_t>(n));
+}
+
+inline static const uint8_t* unpack_varint(const uint8_t* p, uint32_t* n) {
+  uint32_t result = 0;
+  int shift = 0;
+  while (*p & 0x80) {
+    result |= static_cast<uint32_t>(*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  *n = result | (static_cast<uint32_t>(*p++) << shift);
+  return p;
+}
+
+void TableAccessor::UnpackEntry() {
+  uint32_t delta;
+  packed_entries_ = unpack_varint(packed_entries_, &delta);
+  auto& str_id = unpacked_entry_.text.str_id();
+  str_id = static_cast<StringId>(str_id + zigzag_decode(delta));
+  packed_entries_ = unpack_varint(packed_entries_, &delta);
+  unpacked_weight_ += zigzag_decode(delta);
+  unpacked_entry_.weight =
+      static_cast<table::Weight>(unpacked_weight_ / kPackedWeightScale);
+}
 
 bool TableAccessor::exhausted() const {
-  if (entries_ || long_entries_) {
+  if (entries_ || long_entries_ || packed_entries_) {
     return !(size_ - cursor_);
   }
   return true;
 }
 
 size_t TableAccessor::remaining() const {
-  if (entries_ || long_entries_) {
+  if (entries_ || long_entries_ || packed_entries_) {
     return size_ - cursor_;
   }
   return 0;
@@ -70,6 +144,8 @@ const table::Entry* TableAccessor::entry() const {
     return NULL;
   if (entries_)
     return &entries_[cursor_];
+  else if (packed_entries_)
+    return &unpacked_entry_;
   else
     return &long_entries_[cursor_].entry;
 }
@@ -80,14 +156,19 @@ const table::Code* TableAccessor::extra_code() const {
   return &long_entries_[cursor_].extra_code;
 }
 
+Code TableAccessor::index_code() const {
+  Code code;
+  code.assign(index_code_, index_code_ + index_code_size_);
+  return code;
+}
+
 Code TableAccessor::code() const {
   auto extra = extra_code();
-  if (!extra) {
-    return index_code();
-  }
-  Code code(index_code());
-  for (auto p = extra->begin(); p != extra->end(); ++p) {
-    code.push_back(*p);
+  Code code;
+  code.reserve(index_code_size_ + (extra ? extra->size : 0));
+  code.assign(index_code_, index_code_ + index_code_size_);
+  if (extra) {
+    code.insert(code.end(), extra->begin(), extra->end());
   }
   return code;
 }
@@ -95,10 +176,31 @@ Code TableAccessor::code() const {
 bool TableAccessor::Next() {
   if (exhausted())
     return false;
-  ++cursor_;
+  if (++cursor_ < size_ && packed_entries_) {
+    UnpackEntry();
+  }
+  return !exhausted();
+}
+
+bool TableAccessor::Skip(size_t num_entries) {
+  if (packed_entries_) {
+    // entries are unpacked in sequence
+    for (; num_entries > 0 && Next(); --num_entries) {
+    }
+    return !exhausted();
+  }
+  cursor_ = (std::min)(size_, cursor_ + num_entries);
   return !exhausted();
 }
 
+TableAccessor TableAccessor::CurrentEntry() const {
+  TableAccessor accessor(*this);
+  if (!exhausted()) {
+    accessor.size_ = cursor_ + 1;
+  }
+  return accessor;
+}
+
 bool TableQuery::Advance(SyllableId syllable_id,
                          double credibility,
                          double quality_len,
@@ -106,11 +208,11 @@ bool TableQuery::Advance(SyllableId syllable_id,
   if (!Walk(syllable_id)) {
     return false;
   }
+  index_code_[level_] = syllable_id;
+  credibility_[level_] = credibility_sum() + credibility;
+  quality_len_[level_] = quality_len_sum() + quality_len;
+  last_pos_[level_] = last_pos;
   ++level_;
-  index_code_.push_back(syllable_id);
-  credibility_.push_back(credibility_sum() + credibility);
-  quality_len_.push_back(quality_len_sum() + quality_len);
-  last_pos_.push_back(last_pos);
   return true;
 }
 
@@ -118,21 +220,11 @@ bool TableQuery::Backdate() {
   if (level_ == 0)
     return false;
   --level_;
-  if (index_code_.size() > level_) {
-    index_code_.pop_back();
-    credibility_.pop_back();
-    quality_len_.pop_back();
-    last_pos_.pop_back();
-  }
   return true;
 }
 
 void TableQuery::Reset() {
   level_ = 0;
-  index_code_.clear();
-  credibility_.clear();
-  quality_len_.clear();
-  last_pos_.clear();
 }
 
 inline static bool node_less(const table::TrunkIndexNode& a,
@@ -140,13 +232,38 @@ inline static bool node_less(const table::TrunkIndexNode& a,
   return a.key < b.key;
 }
 
-static table::TrunkIndexNode* find_node(table::TrunkIndexNode* first,
-                                        table::TrunkIndexNode* last,
-                                        const SyllableId& key) {
+// the hash table is stored right after the nodes of the trunk index.
+inline static table::TrunkHash* trunk_hash(table::TrunkIndex* index) {
+  return reinterpret_cast<table::TrunkHash*>(index->end());
+}
+
+inline static uint32_t trunk_hash_slot(SyllableId key, uint32_t shift) {
+  // fibonacci hashing
+  return (static_cast<uint32_t>(key) * 2654435769u) >> shift;
+}
+
+static table::TrunkIndexNode* find_node(table::TrunkIndex* index,
+                                        SyllableId key,
+                                        bool hashed) {
+  if (hashed && index->size >= table::kTrunkHashMinSize) {
+    if (key < 0)
+      return nullptr;
+    auto hash = trunk_hash(index);
+    uint32_t mask = (1u << (32 - hash->shift)) - 1;
+    // the table is never more than two thirds full
+    for (uint32_t i = trunk_hash_slot(key, hash->shift);; i = (i + 1) & mask) {
+      const auto& slot = hash->slots[i];
+      if (slot.key == key)
+        return &index->at[slot.node];
+      if (slot.key < 0)
+        return nullptr;
+    }
+  }
   table::TrunkIndexNode target;
   target.key = key;
-  auto it = std::lower_bound(first, last, target, node_less);
-  return it == last || key < it->key ? last : it;
+  auto last = index->end();
+  auto it = std::lower_bound(index->begin(), last, target, node_less);
+  return it == last || key < it->key ? nullptr : it;
 }
 
 bool TableQuery::Walk(SyllableId syllable_id) {
@@ -161,19 +278,15 @@ bool TableQuery::Walk(SyllableId syllable_id) {
   } else if (level_ == 1) {
     if (!lv2_index_)
       return false;
-    auto node = find_node(lv2_index_->begin(), lv2_index_->end(), syllable_id);
-    if (node == lv2_index_->end())
-      return false;
-    if (!node->next_level)
+    auto node = find_node(lv2_index_, syllable_id, hashed_trunk_);
+    if (!node || !node->next_level)
       return false;
     lv3_index_ = &node->next_level->trunk();
   } else if (level_ == 2) {
     if (!lv3_index_)
       return false;
-    auto node = find_node(lv3_index_->begin(), lv3_index_->end(), syllable_id);
-    if (node == lv3_index_->end())
-      return false;
-    if (!node->next_level)
+    auto node = find_node(lv3_index_, syllable_id, hashed_trunk_);
+    if (!node || !node->next_level)
       return false;
     lv4_index_ = &node->next_level->tail();
   } else {
@@ -182,40 +295,56 @@ bool TableQuery::Walk(SyllableId syllable_id) {
   return true;
 }
 
-inline static Code add_syllable(Code code, SyllableId syllable_id) {
-  code.push_back(syllable_id);
-  return code;
-}
-
 TableAccessor TableQuery::Access(SyllableId syllable_id,
                                  double credibility,
                                  double quality_len) const {
   credibility += credibility_sum();
   quality_len += quality_len_sum();
+  SyllableId code[Code::kIndexCodeMaxLength];
+  if (level_ < Code::kIndexCodeMaxLength) {
+    std::copy(index_code_, index_code_ + level_, code);
+    code[level_] = syllable_id;
+  }
   if (level_ == 0) {
     if (!lv1_index_ || syllable_id < 0 ||
         syllable_id >= static_cast<SyllableId>(lv1_index_->size))
       return TableAccessor();
     auto node = &lv1_index_->at[syllable_id];
-    return TableAccessor(add_syllable(index_code_, syllable_id), &node->entries,
-                         credibility, quality_len);
+    return AccessEntries(code, level_ + 1, &node->entries, credibility,
+                         quality_len);
   } else if (level_ == 1 || level_ == 2) {
     auto index = (level_ == 1) ? lv2_index_ : lv3_index_;
     if (!index)
       return TableAccessor();
-    auto node = find_node(index->begin(), index->end(), syllable_id);
-    if (node == index->end())
+    auto node = find_node(index, syllable_id, hashed_trunk_);
+    if (!node)
       return TableAccessor();
-    return TableAccessor(add_syllable(index_code_, syllable_id), &node->entries,
-                         credibility, quality_len);
+    return AccessEntries(code, level_ + 1, &node->entries, credibility,
+                         quality_len);
   } else if (level_ == 3) {
     if (!lv4_index_)
       return TableAccessor();
-    return TableAccessor(index_code_, lv4_index_, credibility, quality_len);
+    return TableAccessor(index_code_, level_, lv4_index_, credibility,
+                         quality_len);
   }
   return TableAccessor();
 }
 
+TableAccessor TableQuery::AccessEntries(const SyllableId* index_code,
+                                        size_t index_code_size,
+                                        const List<table::Entry>* entries,
+                                        double credibility,
+                                        double quality_len) const {
+  if (packed_entries_) {
+    return TableAccessor(
+        index_code, index_code_size,
+        reinterpret_cast<const table::PackedEntryList*>(entries), credibility,
+        quality_len);
+  }
+  return TableAccessor(index_code, index_code_size, entries, credibility,
+                       quality_len);
+}
+
 // string Table::GetString_v1(const table::StringType& x) {
 //  return x.str().c_str();
 // }
@@ -226,7 +355,8 @@ TableAccessor TableQuery::Access(SyllableId syllable_id,
 // }
 
 string Table::GetString(const table::StringType& x) {
-  return string_table_->GetString(x.str_id());
+  string buffer;
+  return string(GetStringView(x.str_id(), &buffer));
 }
 
 bool Table::AddString(const string& src,
@@ -241,8 +371,80 @@ bool Table::OnBuildStart() {
   return true;
 }
 
+bool Table::PackEntryLists() {
+  vector<uint8_t> packed;
+  vector<size_t> offsets;
+  offsets.reserve(lists_to_pack_.size());
+  for (const auto& x : lists_to_pack_) {
+    offsets.push_back(packed.size());
+    StringId last_str_id = 0;
+    int32_t last_weight = 0;
+    for (const auto& e : x.second) {
+      StringId str_id = e.text.str_id();
+      int32_t weight =
+          static_cast<int32_t>(std::lround(e.weight * kPackedWeightScale));
+      pack_varint(zigzag_encode(static_cast<int32_t>(str_id - last_str_id)),
+                  &packed);
+      pack_varint(zigzag_encode(weight - last_weight), &packed);
+      last_str_id = str_id;
+      last_weight = weight;
+    }
+  }
+  LOG(INFO) << "packed entry lists: " << packed.size() << " bytes.";
+  uint8_t* image = Allocate<uint8_t>(packed.size());
+  if (!image) {
+    LOG(ERROR) << "Error creating packed entry lists.";
+    return false;
+  }
+  std::copy(packed.begin(), packed.end(), image);
+  // the file may have been remapped by Allocate(); locate lists by offset.
+  for (size_t i = 0; i < lists_to_pack_.size(); ++i) {
+    auto list = reinterpret_cast<table::PackedEntryList*>(
+        address() + lists_to_pack_[i].first);
+    if (list->size > 0) {
+      list->at = image + offsets[i];
+    }
+  }
+  decltype(lists_to_pack_)().swap(lists_to_pack_);
+  return true;
+}
+
+bool Table::BuildStringPool() {
+  size_t num_strings = string_table_builder_->NumKeys();
+  vector<uint32_t> offsets;
+  offsets.reserve(num_strings + 1);
+  string data;
+  string text;
+  for (StringId string_id = 0; string_id < num_strings; ++string_id) {
+    offsets.push_back(data.length());
+    string_table_builder_->GetString(string_id, &text);
+    data += text;
+  }
+  offsets.push_back(data.length());
+  LOG(INFO) << "string pool: " << data.length() << " bytes.";
+  auto pool = Allocate<table::StringPool>();
+  uint32_t* offsets_image = Allocate<uint32_t>(offsets.size());
+  char* data_image = Allocate<char>(data.length() + 1);
+  if (!pool || !offsets_image || !data_image) {
+    LOG(ERROR) << "Error creating string pool.";
+    return false;
+  }
+  std::copy(offsets.begin(), offsets.end(), offsets_image);
+  std::copy(data.begin(), data.end(), data_image);
+  pool->offsets.size = offsets.size();
+  pool->offsets.at = offsets_image;
+  pool->data = data_image;
+  metadata_->string_pool = pool;
+  string_pool_ = pool;
+  return true;
+}
+
 bool Table::OnBuildFinish() {
   string_table_builder_->Build();
+  // string ids are known from here on
+  if (packed_entries_ ? !PackEntryLists() : !BuildStringPool()) {
+    return false;
+  }
   // saving string table image
   size_t image_size = string_table_builder_->BinarySize();
   char* image = Allocate<char>(image_size);
@@ -295,6 +497,17 @@ bool Table::Load() {
                << kTableFormatLatest;
     return false;
   }
+  if (format_version >= kTableFormatIncompatible - DBL_EPSILON) {
+    LOG(ERROR) << "table format version " << format_version
+               << " is not supported by this version of librime.";
+    Close();
+    return false;
+  }
+  format_version_ = format_version;
+  bool v5 = format_version >= kTableFormatHashedTrunk - DBL_EPSILON;
+  hashed_trunk_ = v5;
+  packed_entries_ = v5 && metadata_->packed_entries;
+  string_pool_ = v5 ? metadata_->string_pool.get() : nullptr;
 
   syllabary_ = metadata_->syllabary.get();
   if (!syllabary_) {
@@ -327,10 +540,15 @@ uint32_t Table::dict_file_checksum() const {
   return metadata_ ? metadata_->dict_file_checksum : 0;
 }
 
+bool Table::outdated() const {
+  return format_version_ < kTableFormatVersion - DBL_EPSILON;
+}
+
 bool Table::Build(const Syllabary& syllabary,
                   const Vocabulary& vocabulary,
                   size_t num_entries,
-                  uint32_t dict_file_checksum) {
+                  uint32_t dict_file_checksum,
+                  bool compact) {
   const size_t kReservedSize = 4096;
   size_t num_syllables = syllabary.size();
   size_t estimated_file_size =
@@ -353,6 +571,8 @@ bool Table::Build(const Syllabary& syllabary,
   metadata_->dict_file_checksum = dict_file_checksum;
   metadata_->num_syllables = num_syllables;
   metadata_->num_entries = num_entries;
+  metadata_->packed_entries = compact;
+  packed_entries_ = compact;
 
   if (!OnBuildStart()) {
     return false;
@@ -372,6 +592,7 @@ bool Table::Build(const Syllabary& syllabary,
   metadata_->syllabary = syllabary_;
 
   LOG(INFO) << "creating table index.";
+  hashed_trunk_ = true;
   index_ = BuildIndex(vocabulary, num_syllables);
   if (!index_) {
     LOG(ERROR) << "Error creating table index.";
@@ -386,6 +607,9 @@ bool Table::Build(const Syllabary& syllabary,
   // at last, complete the metadata
   std::strncpy(metadata_->format, kTableFormatLatest,
                table::Metadata::kFormatMaxLength);
+  LOG(INFO) << "table size: " << file_size() << " bytes, "
+            << (num_entries ? double(file_size()) / num_entries : 0.0)
+            << " bytes per entry.";
   return true;
 }
 
@@ -421,9 +645,47 @@ table::HeadIndex* Table::BuildHeadIndex(const Vocabulary& vocabulary,
   return index;
 }
 
+table::TrunkIndex* Table::CreateTrunkIndex(const Vocabulary& vocabulary) {
+  size_t size = vocabulary.size();
+  if (size < table::kTrunkHashMinSize) {
+    return CreateArray<table::TrunkIndexNode>(size);
+  }
+  uint32_t shift = 32;
+  size_t num_slots = 1;
+  while (2 * num_slots < 3 * size) {
+    num_slots <<= 1;
+    --shift;
+  }
+  size_t num_bytes = sizeof(table::TrunkIndex) +
+                     sizeof(table::TrunkIndexNode) * (size - 1) +
+                     sizeof(table::TrunkHash) +
+                     sizeof(table::TrunkHashSlot) * (num_slots - 1);
+  auto index = reinterpret_cast<table::TrunkIndex*>(Allocate<char>(num_bytes));
+  if (!index) {
+    return NULL;
+  }
+  index->size = size;
+  auto hash = trunk_hash(index);
+  hash->shift = shift;
+  for (size_t i = 0; i < num_slots; ++i) {
+    hash->slots[i].key = -1;
+  }
+  int32_t node = 0;
+  for (const auto& v : vocabulary) {
+    SyllableId key = v.first;
+    uint32_t i = trunk_hash_slot(key, shift);
+    while (hash->slots[i].key >= 0) {
+      i = (i + 1) & (num_slots - 1);
+    }
+    hash->slots[i].key = key;
+    hash->slots[i].node = node++;
+  }
+  return index;
+}
+
 table::TrunkIndex* Table::BuildTrunkIndex(const Code& prefix,
                                           const Vocabulary& vocabulary) {
-  auto index = CreateArray<table::TrunkIndexNode>(vocabulary.size());
+  auto index = CreateTrunkIndex(vocabulary);
   if (!index) {
     return NULL;
   }
@@ -507,6 +769,17 @@ bool Table::BuildEntryList(const ShortDictEntryList& src,
   if (!dest)
     return false;
   dest->size = src.size();
+  if (packed_entries_) {
+    // to be packed by PackEntryLists()
+    size_t offset = reinterpret_cast<char*>(dest) - address();
+    lists_to_pack_.emplace_back(offset, vector<table::Entry>(src.size()));
+    auto& entries = lists_to_pack_.back().second;
+    for (size_t i = 0; i < src.size(); ++i) {
+      if (!BuildEntry(*src[i], &entries[i]))
+        return false;
+    }
+    return true;
+  }
   dest->at = Allocate<table::Entry>(src.size());
   if (!dest->at) {
     LOG(ERROR) << "Error creating table entries; file size: " << file_size();
@@ -547,15 +820,19 @@ string Table::GetSyllableById(SyllableId syllable_id) {
   return GetString(syllabary_->at[syllable_id]);
 }
 
+TableQuery Table::NewQuery() const {
+  return TableQuery(index_, hashed_trunk_, packed_entries_);
+}
+
 TableAccessor Table::QueryWords(SyllableId syllable_id) {
-  TableQuery query(index_);
+  TableQuery query = NewQuery();
   return query.Access(syllable_id);
 }
 
 TableAccessor Table::QueryPhrases(const Code& code) {
   if (code.empty())
     return TableAccessor();
-  TableQuery query(index_);
+  TableQuery query = NewQuery();
   for (size_t i = 0; i < Code::kIndexCodeMaxLength; ++i) {
     if (code.size() == i + 1)
       return query.Access(code[i]);
@@ -565,6 +842,40 @@ TableAccessor Table::QueryPhrases(const Code& code) {
   return query.Access(-1);
 }
 
+TableQueryResult::mapped_type& TableQueryResult::operator[](size_t end_pos) {
+  if (end_pos >= group_index_.size()) {
+    group_index_.resize(end_pos + 1, -1);
+  }
+  int& i = group_index_[end_pos];
+  if (i < 0) {
+    i = static_cast<int>(groups_.size());
+    groups_.emplace_back(end_pos, vector<TableAccessor>());
+  }
+  return groups_[i].second;
+}
+
+TableQueryResult::iterator TableQueryResult::find(size_t end_pos) {
+  if (end_pos >= group_index_.size() || group_index_[end_pos] < 0)
+    return groups_.end();
+  return groups_.begin() + group_index_[end_pos];
+}
+
+TableQueryResult::const_iterator TableQueryResult::find(size_t end_pos) const {
+  if (end_pos >= group_index_.size() || group_index_[end_pos] < 0)
+    return groups_.end();
+  return groups_.begin() + group_index_[end_pos];
+}
+
+void TableQueryResult::SortGroups() {
+  std::sort(groups_.begin(), groups_.end(),
+            [](const value_type& a, const value_type& b) {
+              return a.first < b.first;
+            });
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    group_index_[groups_[i].first] = static_cast<int>(i);
+  }
+}
+
 // log(0.05) ≈ -3.0
 const double kPenaltyForAmbiguousSyllable = -2.995732274;
 
@@ -573,64 +884,142 @@ bool Table::Query(const SyllableGraph& syll_graph,
                   TableQueryResult* result) {
   if (!result || !index_ || start_pos >= syll_graph.interpreted_length)
     return false;
-  result->clear();
-  std::queue<pair<size_t, TableQuery>> q;
-  TableQuery initial_state(index_);
-  q.push({start_pos, initial_state});
-  while (!q.empty()) {
-    size_t current_pos = q.front().first;
-    TableQuery query(q.front().second);
-    q.pop();
-    auto index = syll_graph.indices.find(current_pos);
-    if (index == syll_graph.indices.end()) {
+  Query(syll_graph, {start_pos}, {result});
+  return !result->empty();
+}
+
+void Table::Query(const SyllableGraph& syll_graph,
+                  const vector<size_t>& start_positions,
+                  const vector<TableQueryResult*>& results) {
+  for (auto result : results) {
+    result->clear();
+  }
+  if (!index_)
+    return;
+  // edges from each vertex, flattened on the first visit and shared by the
+  // queries from all start positions.
+  struct Edge {
+    SyllableId syllable_id;
+    const EdgeProperties* props;
+  };
+  vector<Edge> edges;
+  // [begin, end) in edges by vertex; begin > end if not yet visited
+  vector<pair<size_t, size_t>> edge_ranges(syll_graph.interpreted_length,
+                                           {1, 0});
+  auto edges_from = [&](size_t pos) -> pair<size_t, size_t> {
+    auto& range = edge_ranges[pos];
+    if (range.first > range.second) {
+      range.first = range.second = edges.size();
+      if (auto index = syll_graph.indices.find(pos)) {
+        for (const auto& spellings : *index) {
+          for (auto props : spellings.spellings) {
+            edges.push_back({spellings.syllable_id, props});
+          }
+        }
+        range.second = edges.size();
+      }
+    }
+    return range;
+  };
+  // breadth-first from all start positions at once, so that each query
+  // finds accessors in the same order as if it were made on its own. the
+  // visited states are kept in a flat queue, which is cheap to grow as
+  // TableQuery does not allocate.
+  struct State {
+    size_t start_index;
+    size_t pos;
+    TableQuery query;
+  };
+  vector<State> q;
+  vector<size_t> horizons(start_positions.size());
+  for (size_t i = 0; i < start_positions.size(); ++i) {
+    horizons[i] = start_positions[i];
+    if (start_positions[i] < syll_graph.interpreted_length)
+      q.push_back({i, start_positions[i], NewQuery()});
+  }
+  for (size_t head = 0; head < q.size(); ++head) {
+    size_t start_index = q[head].start_index;
+    size_t current_pos = q[head].pos;
+    TableQuery query(q[head].query);
+    auto range = edges_from(current_pos);
+    if (range.first == range.second) {
       continue;
     }
+    TableQueryResult& result = *results[start_index];
     if (query.level() == Code::kIndexCodeMaxLength) {
       TableAccessor accessor(query.Access(-1));
       if (!accessor.exhausted()) {
-        (*result)[current_pos].push_back(accessor);
+        result[current_pos].push_back(accessor);
       }
       continue;
     }
-    for (const auto& spellings : index->second) {
-      SyllableId syll_id = spellings.first;
-      for (auto props : spellings.second) {
-        size_t end_pos = props->end_pos;
-
-        double penalty = 0.0;
-        if (false) {
-          size_t last_pos = query.last_pos();
-          if (props->ambiguous_source_positions.count(last_pos)) {
-            penalty = kPenaltyForAmbiguousSyllable;
-            DLOG(INFO) << "conditional penalty applied: ambiguous path ["
-                       << last_pos << ", " << end_pos << ")";
-          }
-        }
-        double next_credibility = props->credibility + penalty;
-
-        // 全碼匹配長度積分
-        bool is_normal_spelling = props->type == kNormalSpelling;
-        double delta_quality_len =
-            (is_normal_spelling ? 1.0 : 0.0) * (end_pos - current_pos);
-        TableAccessor accessor =
-            query.Access(syll_id, next_credibility, delta_quality_len);
-        if (!accessor.exhausted()) {
-          (*result)[end_pos].push_back(accessor);
+    for (size_t k = range.first; k < range.second; ++k) {
+      SyllableId syll_id = edges[k].syllable_id;
+      const EdgeProperties* props = edges[k].props;
+      size_t end_pos = props->end_pos;
+
+      double penalty = 0.0;
+      if (false) {
+        size_t last_pos = query.last_pos();
+        if (props->IsAmbiguousFrom(last_pos)) {
+          penalty = kPenaltyForAmbiguousSyllable;
+          DLOG(INFO) << "conditional penalty applied: ambiguous path ["
+                     << last_pos << ", " << end_pos << ")";
         }
-        if (end_pos < syll_graph.interpreted_length &&
-            query.Advance(syll_id, next_credibility, delta_quality_len,
-                          current_pos)) {
-          q.push({end_pos, query});
-          query.Backdate();
+      }
+      double next_credibility = props->credibility + penalty;
+
+      // 全碼匹配長度積分
+      bool is_normal_spelling = props->type == kNormalSpelling;
+      double delta_quality_len =
+          (is_normal_spelling ? 1.0 : 0.0) * (end_pos - current_pos);
+      TableAccessor accessor =
+          query.Access(syll_id, next_credibility, delta_quality_len);
+      if (!accessor.exhausted()) {
+        result[end_pos].push_back(accessor);
+      }
+      if (query.Advance(syll_id, next_credibility, delta_quality_len,
+                        current_pos)) {
+        // only then does the query depend on what follows end_pos
+        horizons[start_index] = (std::max)(horizons[start_index], end_pos);
+        if (end_pos < syll_graph.interpreted_length) {
+          q.push_back({start_index, end_pos, query});
         }
+        query.Backdate();
       }
     }
   }
-  return !result->empty();
+  for (size_t i = 0; i < results.size(); ++i) {
+    results[i]->SortGroups();
+    results[i]->horizon_ = horizons[i];
+  }
 }
 
 string Table::GetEntryText(const table::Entry& entry) {
   return GetString(entry.text);
 }
 
+bool Table::GetEntryText(const table::Entry& entry, string* text) {
+  if (string_pool_) {
+    text->assign(GetEntryTextView(entry, text));
+    return true;
+  }
+  return string_table_->GetString(entry.text.str_id(), text);
+}
+
+std::string_view Table::GetEntryTextView(const table::Entry& entry,
+                                         string* buffer) {
+  return GetStringView(entry.text.str_id(), buffer);
+}
+
+std::string_view Table::GetStringView(StringId string_id, string* buffer) {
+  if (string_pool_ && string_id + 1 < string_pool_->offsets.size) {
+    const uint32_t* offsets = string_pool_->offsets.at.get();
+    return std::string_view(string_pool_->data.get() + offsets[string_id],
+                            offsets[string_id + 1] - offsets[string_id]);
+  }
+  string_table_->GetString(string_id, buffer);
+  return *buffer;
+}
+
 }  // namespace rime
@@ -57,6 +57,12 @@ struct LongEntry {
   Entry entry;
 };
 
+// in a compact table, the entries of head and trunk index nodes are packed
+// into a byte stream, where each entry is stored as varint encoded deltas of
+// string id and quantized weight from the previous entry in the list.
+// size is the number of entries.
+using PackedEntryList = List<uint8_t>;
+
 struct PhraseIndex;
 
 struct HeadIndexNode {
@@ -74,6 +80,24 @@ struct TrunkIndexNode {
 
 using TrunkIndex = Array<TrunkIndexNode>;
 
+// since v5.0, a trunk index of at least kTrunkHashMinSize nodes is followed
+// by an open addressing hash table of its keys, so that a node is found in
+// one or two probes rather than by binary search over the nodes.
+const size_t kTrunkHashMinSize = 32;
+
+struct TrunkHashSlot {
+  // -1 if the slot is empty
+  SyllableId key;
+  // position of the node in the trunk index
+  int32_t node;
+};
+
+struct TrunkHash {
+  // 32 - log2(number of slots)
+  uint32_t shift;
+  TrunkHashSlot slots[1];
+};
+
 using TailIndex = Array<LongEntry>;
 
 // union PhraseIndex {
@@ -84,6 +108,13 @@ RIME_TABLE_UNION(PhraseIndex, Array<char>, TrunkIndex, trunk, TailIndex, tail);
 
 using Index = HeadIndex;
 
+// texts of the string table laid out by string id, to be read in place
+struct StringPool {
+  // string i spans data[offsets[i]] to data[offsets[i + 1]]
+  List<uint32_t> offsets;
+  OffsetPtr<char> data;
+};
+
 struct Metadata {
   static const int kFormatMaxLength = 32;
   char format[kFormatMaxLength];
@@ -93,8 +124,10 @@ struct Metadata {
   OffsetPtr<Syllabary> syllabary;
   OffsetPtr<Index> index;
   // v2
-  int32_t reserved_1;
-  int32_t reserved_2;
+  // v5.0: non-zero if entry lists are packed
+  int32_t packed_entries;
+  // v5.0: absent in compact tables
+  OffsetPtr<StringPool> string_pool;
   OffsetPtr<char> string_table;
   uint32_t string_table_size;
 };
@@ -104,47 +137,127 @@ struct Metadata {
 class TableAccessor {
  public:
   TableAccessor() = default;
-  TableAccessor(const Code& index_code,
+  TableAccessor(const SyllableId* index_code,
+                size_t index_code_size,
                 const List<table::Entry>* entries,
                 double credibility = 0.0,
                 double quality_len = 0.0);
-  TableAccessor(const Code& index_code,
+  TableAccessor(const SyllableId* index_code,
+                size_t index_code_size,
                 const Array<table::Entry>* entries,
                 double credibility = 0.0,
                 double quality_len = 0.0);
-  TableAccessor(const Code& index_code,
+  TableAccessor(const SyllableId* index_code,
+                size_t index_code_size,
                 const table::TailIndex* code_map,
                 double credibility = 0.0,
                 double quality_len = 0.0);
+  TableAccessor(const SyllableId* index_code,
+                size_t index_code_size,
+                const table::PackedEntryList* packed_list,
+                double credibility = 0.0,
+                double quality_len = 0.0);
 
   RIME_DLL bool Next();
+  // skips up to num_entries entries; returns false if exhausted.
+  RIME_DLL bool Skip(size_t num_entries);
+  // accesses the current entry alone.
+  RIME_DLL TableAccessor CurrentEntry() const;
 
   RIME_DLL bool exhausted() const;
   RIME_DLL size_t remaining() const;
   RIME_DLL const table::Entry* entry() const;
   RIME_DLL const table::Code* extra_code() const;
-  const Code& index_code() const { return index_code_; }
+  Code index_code() const;
+  size_t index_code_size() const { return index_code_size_; }
   Code code() const;
   double credibility() const { return credibility_; }
   double quality_len() const { return quality_len_; }
 
  private:
-  Code index_code_;
+  void SetIndexCode(const SyllableId* index_code, size_t index_code_size);
+  void UnpackEntry();
+
+  // stored in place, so that accessors are cheap to copy
+  SyllableId index_code_[Code::kIndexCodeMaxLength] = {};
+  size_t index_code_size_ = 0;
   const table::Entry* entries_ = nullptr;
   const table::LongEntry* long_entries_ = nullptr;
+  // packed entries are decoded one at a time, starting here
+  const uint8_t* packed_entries_ = nullptr;
+  table::Entry unpacked_entry_ = {};
+  int32_t unpacked_weight_ = 0;
   size_t size_ = 0;
   size_t cursor_ = 0;
   double credibility_ = 0.0;
   double quality_len_ = 0.0;
 };
 
-using TableQueryResult = map<int, vector<TableAccessor>>;
-
 struct SyllableGraph;
 
+// accessors found by Table::Query, grouped by the end position of their
+// index code in the syllable graph, in ascending order of end position.
+//
+// formerly an alias of map<int, vector<TableAccessor>>, of which it keeps
+// the lookup and iteration interface; groups cannot be erased, though, and
+// the key of value_type is size_t rather than const int.
+class TableQueryResult {
+ public:
+  using key_type = size_t;
+  using mapped_type = vector<TableAccessor>;
+  using value_type = pair<key_type, mapped_type>;
+  using iterator = vector<value_type>::iterator;
+  using const_iterator = vector<value_type>::const_iterator;
+  using reverse_iterator = vector<value_type>::reverse_iterator;
+  using const_reverse_iterator = vector<value_type>::const_reverse_iterator;
+
+  // creates the group if not found.
+  RIME_DLL mapped_type& operator[](size_t end_pos);
+  RIME_DLL iterator find(size_t end_pos);
+  RIME_DLL const_iterator find(size_t end_pos) const;
+  size_t count(size_t end_pos) const { return find(end_pos) != end(); }
+
+  iterator begin() { return groups_.begin(); }
+  iterator end() { return groups_.end(); }
+  const_iterator begin() const { return groups_.begin(); }
+  const_iterator end() const { return groups_.end(); }
+  reverse_iterator rbegin() { return groups_.rbegin(); }
+  reverse_iterator rend() { return groups_.rend(); }
+  const_reverse_iterator rbegin() const { return groups_.rbegin(); }
+  const_reverse_iterator rend() const { return groups_.rend(); }
+  size_t size() const { return groups_.size(); }
+  bool empty() const { return groups_.empty(); }
+  void clear() {
+    groups_.clear();
+    group_index_.clear();
+    horizon_ = 0;
+  }
+  // the query depends on no edges of the syllable graph that start after
+  // this position.
+  size_t horizon() const { return horizon_; }
+
+ private:
+  friend class Table;
+  // restores the order of groups added out of order.
+  void SortGroups();
+
+  vector<value_type> groups_;
+  // position of group in groups_ by end position, or -1 if none.
+  vector<int> group_index_;
+  size_t horizon_ = 0;
+};
+
 class TableQuery {
  public:
-  TableQuery(table::Index* index) : lv1_index_(index) { Reset(); }
+  // trunk indices of tables of format v5.0 and above can be searched by hash.
+  TableQuery(table::Index* index,
+             bool hashed_trunk = false,
+             bool packed_entries = false)
+      : lv1_index_(index),
+        hashed_trunk_(hashed_trunk),
+        packed_entries_(packed_entries) {
+    Reset();
+  }
 
   TableAccessor Access(SyllableId syllable_id,
                        double credibility = 0.0,
@@ -165,27 +278,36 @@ class TableQuery {
   size_t level() const { return level_; }
 
   double credibility_sum() const {
-    return credibility_.empty() ? 0 : credibility_.back();
+    return level_ ? credibility_[level_ - 1] : 0;
   }
   double quality_len_sum() const {
-    return quality_len_.empty() ? 0 : quality_len_.back();
+    return level_ ? quality_len_[level_ - 1] : 0;
   }
-  size_t last_pos() const { return last_pos_.empty() ? 0 : last_pos_.back(); }
+  size_t last_pos() const { return level_ ? last_pos_[level_ - 1] : 0; }
 
  protected:
+  // the index is no deeper than kIndexCodeMaxLength levels, so states are
+  // kept in fixed-size arrays and a query can be copied without allocation.
   size_t level_ = 0;
-  Code index_code_;
-  vector<double> credibility_;
-  vector<double> quality_len_;
-  vector<size_t> last_pos_;
+  SyllableId index_code_[Code::kIndexCodeMaxLength];
+  double credibility_[Code::kIndexCodeMaxLength];
+  double quality_len_[Code::kIndexCodeMaxLength];
+  size_t last_pos_[Code::kIndexCodeMaxLength];
 
  private:
   bool Walk(SyllableId syllable_id);
+  TableAccessor AccessEntries(const SyllableId* index_code,
+                              size_t index_code_size,
+                              const List<table::Entry>* entries,
+                              double credibility,
+                              double quality_len) const;
 
   table::HeadIndex* lv1_index_ = nullptr;
   table::TrunkIndex* lv2_index_ = nullptr;
   table::TrunkIndex* lv3_index_ = nullptr;
   table::TailIndex* lv4_index_ = nullptr;
+  bool hashed_trunk_ = false;
+  bool packed_entries_ = false;
 };
 
 class Table : public MappedFile {
@@ -195,11 +317,15 @@ class Table : public MappedFile {
 
   RIME_DLL bool Load();
   RIME_DLL bool Save();
+  // entry lists are packed if compact is true, at some cost of speed and
+  // precision of weights.
   RIME_DLL bool Build(const Syllabary& syllabary,
                       const Vocabulary& vocabulary,
                       size_t num_entries,
-                      uint32_t dict_file_checksum = 0);
+                      uint32_t dict_file_checksum = 0,
+                      bool compact = false);
 
+  RIME_DLL TableQuery NewQuery() const;
   bool GetSyllabary(Syllabary* syllabary);
   RIME_DLL string GetSyllableById(int syllable_id);
   RIME_DLL TableAccessor QueryWords(int syllable_id);
@@ -207,15 +333,30 @@ class Table : public MappedFile {
   RIME_DLL bool Query(const SyllableGraph& syll_graph,
                       size_t start_pos,
                       TableQueryResult* result);
+  // queries from each of the start positions in one traversal of the graph;
+  // results are given in the same order as start positions.
+  RIME_DLL void Query(const SyllableGraph& syll_graph,
+                      const vector<size_t>& start_positions,
+                      const vector<TableQueryResult*>& results);
   RIME_DLL string GetEntryText(const table::Entry& entry);
+  // writes entry text to *text, reusing its storage.
+  RIME_DLL bool GetEntryText(const table::Entry& entry, string* text);
+  // views entry text in the string pool if available; otherwise the text is
+  // decoded into *buffer, which is left untouched in the former case.
+  RIME_DLL std::string_view GetEntryTextView(const table::Entry& entry,
+                                             string* buffer);
+  bool has_string_pool() const { return string_pool_ != nullptr; }
 
   uint32_t dict_file_checksum() const;
+  // true if the table was built in an older format than the latest.
+  RIME_DLL bool outdated() const;
   table::Metadata* metadata() const { return metadata_; }
 
  private:
   table::Index* BuildIndex(const Vocabulary& vocabulary, size_t num_syllables);
   table::HeadIndex* BuildHeadIndex(const Vocabulary& vocabulary,
                                    size_t num_syllables);
+  table::TrunkIndex* CreateTrunkIndex(const Vocabulary& vocabulary);
   table::TrunkIndex* BuildTrunkIndex(const Code& prefix,
                                      const Vocabulary& vocabulary);
   table::TailIndex* BuildTailIndex(const Code& prefix,
@@ -228,8 +369,11 @@ class Table : public MappedFile {
   bool BuildEntry(const ShortDictEntry& dict_entry, table::Entry* entry);
 
   string GetString(const table::StringType& x);
+  std::string_view GetStringView(StringId string_id, string* buffer);
   bool AddString(const string& src, table::StringType* dest, double weight);
   bool OnBuildStart();
+  bool PackEntryLists();
+  bool BuildStringPool();
   bool OnBuildFinish();
   bool OnLoad();
 
@@ -237,9 +381,16 @@ class Table : public MappedFile {
   table::Metadata* metadata_ = nullptr;
   table::Syllabary* syllabary_ = nullptr;
   table::Index* index_ = nullptr;
+  double format_version_ = 0.0;
+  bool hashed_trunk_ = false;
+  bool packed_entries_ = false;
+  table::StringPool* string_pool_ = nullptr;
 
   the<StringTable> string_table_;
   the<StringTableBuilder> string_table_builder_;
+  // entry lists to pack once string ids are known, keyed by their offsets
+  // in the file, which stay valid when the file is resized.
+  vector<pair<size_t, vector<table::Entry>>> lists_to_pack_;
 };
 
 }  // namespace rime
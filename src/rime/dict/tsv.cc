@@ -7,6 +7,7 @@
 #include <fstream>
 #include <boost/algorithm/string.hpp>
 #include <rime/common.h>
+#include <rime/algo/strings.h>
 #include <rime/dict/db_utils.h>
 #include <rime/dict/tsv.h>
 
@@ -28,6 +29,11 @@ int TsvReader::operator()(Sink* sink) {
     // skip empty lines and comments
     if (line.empty())
       continue;
+    if (!strings::utf8_valid(line)) {
+      LOG(WARNING) << "invalid UTF-8 at line " << line_no
+                   << " in file: " << file_path_ << ".";
+      continue;
+    }
     if (enable_comment && line[0] == '#') {
       if (boost::starts_with(line, "#@")) {
         // metadata
@@ -56,6 +62,73 @@ int TsvReader::operator()(Sink* sink) {
   return num_entries;
 }
 
+TsvSource::TsvSource(const path& file_path, TsvParser parser)
+    : file_path_(file_path), parser_(parser), fin_(file_path.c_str()) {}
+
+bool TsvSource::ReadRow() {
+  string line;
+  while (getline(fin_, line)) {
+    ++line_no_;
+    boost::algorithm::trim_right(line);
+    if (line.empty())
+      continue;
+    if (!strings::utf8_valid(line)) {
+      LOG(WARNING) << "invalid UTF-8 at line " << line_no_
+                   << " in file: " << file_path_ << ".";
+      continue;
+    }
+    is_metadata_ = false;
+    if (enable_comment_ && line[0] == '#') {
+      if (!boost::starts_with(line, "#@")) {
+        if (line == "# no comment")
+          enable_comment_ = false;
+        continue;
+      }
+      line.erase(0, 2);
+      is_metadata_ = true;
+    }
+    boost::algorithm::split(row_, line, boost::algorithm::is_any_of("\t"));
+    has_row_ = true;
+    return true;
+  }
+  return false;
+}
+
+bool TsvSource::MetaGet(string* key, string* value) {
+  while (has_row_ || ReadRow()) {
+    if (!is_metadata_)
+      return false;
+    has_row_ = false;
+    if (row_.size() != 2) {
+      LOG(WARNING) << "invalid metadata at line " << line_no_
+                   << " in file: " << file_path_ << ".";
+      continue;
+    }
+    *key = row_[0];
+    *value = row_[1];
+    return true;
+  }
+  return false;
+}
+
+bool TsvSource::Get(string* key, string* value) {
+  while (has_row_ || ReadRow()) {
+    has_row_ = false;
+    if (is_metadata_) {
+      LOG(WARNING) << "ignored metadata after entries at line " << line_no_
+                   << " in file: " << file_path_ << ".";
+      continue;
+    }
+    if (!parser_(row_, key, value)) {
+      LOG(WARNING) << "invalid entry at line " << line_no_
+                   << " in file: " << file_path_ << ".";
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
 int TsvWriter::operator()(Source* source) {
   if (!source)
     return 0;
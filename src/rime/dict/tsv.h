@@ -7,7 +7,9 @@
 #ifndef RIME_TSV_H_
 #define RIME_TSV_H_
 
+#include <fstream>
 #include <rime/common.h>
+#include <rime/dict/db_utils.h>
 
 namespace rime {
 
@@ -18,9 +20,6 @@ using TsvParser = function<bool(const Tsv& row, string* key, string* value)>;
 using TsvFormatter =
     function<bool(const string& key, const string& value, Tsv* row)>;
 
-class Sink;
-class Source;
-
 class TsvReader {
  public:
   TsvReader(const path& file_path, TsvParser parser)
@@ -48,6 +47,31 @@ class TsvWriter {
   string file_description;
 };
 
+// reads a tsv file record by record, without loading the whole file.
+// metadata are expected at the head of the file, followed by entries.
+class TsvSource : public Source {
+ public:
+  TsvSource(const path& file_path, TsvParser parser);
+
+  bool MetaGet(string* key, string* value) override;
+  bool Get(string* key, string* value) override;
+
+  bool is_open() const { return fin_.is_open(); }
+
+ protected:
+  // reads the next metadata or entry line into row_.
+  bool ReadRow();
+
+  path file_path_;
+  TsvParser parser_;
+  std::ifstream fin_;
+  int line_no_ = 0;
+  bool enable_comment_ = true;
+  Tsv row_;
+  bool has_row_ = false;
+  bool is_metadata_ = false;
+};
+
 template <class SinkType>
 int operator<<(SinkType& sink, TsvReader& reader) {
   return reader(&sink);
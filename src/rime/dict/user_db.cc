@@ -5,6 +5,7 @@
 // 2011-11-02 GONG Chen <chen.sst@gmail.com>
 //
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <boost/algorithm/string.hpp>
 #include <rime/service.h>
@@ -18,13 +19,68 @@ UserDbValue::UserDbValue(const string& value) {
   Unpack(value);
 }
 
+// binary value ::= version:1 commits:4 dee:8 tick:8, integers in little
+// endian and dee in IEEE 754 double precision.
+// the version byte is not printable so that text records are told apart.
+static const char kPackedValueVersion = '\x01';
+static const size_t kPackedValueSize = 1 + 4 + 8 + 8;
+
+static void put_uint(char* dest, uint64_t x, size_t width) {
+  for (size_t i = 0; i < width; ++i) {
+    dest[i] = static_cast<char>((x >> (8 * i)) & 0xff);
+  }
+}
+
+static uint64_t get_uint(const char* src, size_t width) {
+  uint64_t x = 0;
+  for (size_t i = 0; i < width; ++i) {
+    x |= uint64_t(static_cast<unsigned char>(src[i])) << (8 * i);
+  }
+  return x;
+}
+
+bool UserDbValue::IsPacked(const string& value) {
+  return !value.empty() && value[0] == kPackedValueVersion;
+}
+
 string UserDbValue::Pack() const {
+  string packed(kPackedValueSize, '\0');
+  char* p = &packed[0];
+  *p++ = kPackedValueVersion;
+  put_uint(p, static_cast<uint32_t>(commits), 4);
+  p += 4;
+  uint64_t dee_bits;
+  std::memcpy(&dee_bits, &dee, sizeof(dee_bits));
+  put_uint(p, dee_bits, 8);
+  p += 8;
+  put_uint(p, tick, 8);
+  return packed;
+}
+
+string UserDbValue::PackText() const {
   std::ostringstream packed;
   packed << "c=" << commits << " d=" << dee << " t=" << tick;
   return packed.str();
 }
 
 bool UserDbValue::Unpack(const string& value) {
+  if (IsPacked(value)) {
+    if (value.length() != kPackedValueSize) {
+      LOG(ERROR) << "invalid binary userdb value of " << value.length()
+                 << " bytes.";
+      return false;
+    }
+    const char* p = value.data() + 1;
+    commits = static_cast<int32_t>(get_uint(p, 4));
+    p += 4;
+    uint64_t dee_bits = get_uint(p, 8);
+    std::memcpy(&dee, &dee_bits, sizeof(dee));
+    dee = (std::min)(10000.0, dee);
+    p += 8;
+    tick = get_uint(p, 8);
+    return true;
+  }
+  // legacy text record, migrated to the binary format on next update
   vector<string> kv;
   boost::split(kv, value, boost::is_any_of(" "));
   for (const string& k_eq_v : kv) {
@@ -86,7 +142,9 @@ static bool userdb_entry_formatter(const string& key,
   boost::algorithm::split(row, key, boost::algorithm::is_any_of("\t"));
   if (row.size() != 2 || row[0].empty() || row[1].empty())
     return false;
-  row.push_back(value);
+  // text files always keep values in text
+  row.push_back(UserDbValue::IsPacked(value) ? UserDbValue(value).PackText()
+                                             : value);
   return true;
 }
 
@@ -144,18 +202,22 @@ bool UserDbHelper::IsUserDb() {
   return db_->MetaFetch("/db_type", &db_type) && (db_type == "userdb");
 }
 
-string UserDbHelper::GetDbName() {
-  string name;
-  if (!db_->MetaFetch("/db_name", &name))
-    return name;
+// removes ".userdb.*" from the db name in metadata
+static string strip_userdb_extension(string name) {
   auto ext = boost::find_last(name, ".userdb");
   if (!ext.empty()) {
-    // remove ".userdb.*"
     name.erase(ext.begin(), name.end());
   }
   return name;
 }
 
+string UserDbHelper::GetDbName() {
+  string name;
+  if (!db_->MetaFetch("/db_name", &name))
+    return name;
+  return strip_userdb_extension(name);
+}
+
 string UserDbHelper::GetUserId() {
   string user_id("unknown");
   db_->MetaFetch("/user_id", &user_id);
@@ -179,6 +241,25 @@ static TickCount get_tick_count(Db* db) {
   return 1;
 }
 
+// merges their value of an entry into ours, each decayed to the tick count
+// of its own db, and marks it as of the tick count after merging.
+static void merge_value(UserDbValue* o,
+                        UserDbValue v,
+                        TickCount our_tick,
+                        TickCount their_tick,
+                        TickCount max_tick) {
+  if (v.tick < their_tick) {
+    v.dee = algo::formula_d(0, (double)their_tick, v.dee, (double)v.tick);
+  }
+  if (o->tick < our_tick) {
+    o->dee = algo::formula_d(0, (double)our_tick, o->dee, (double)o->tick);
+  }
+  if (std::abs(o->commits) < std::abs(v.commits))
+    o->commits = v.commits;
+  o->dee = (std::max)(o->dee, v.dee);
+  o->tick = max_tick;
+}
+
 UserDbMerger::UserDbMerger(Db* db) : db_(db) {
   our_tick_ = get_tick_count(db);
   their_tick_ = 0;
@@ -203,22 +284,12 @@ bool UserDbMerger::MetaPut(const string& key, const string& value) {
 bool UserDbMerger::Put(const string& key, const string& value) {
   if (!db_)
     return false;
-  UserDbValue v(value);
-  if (v.tick < their_tick_) {
-    v.dee = algo::formula_d(0, (double)their_tick_, v.dee, (double)v.tick);
-  }
   UserDbValue o;
   string our_value;
   if (db_->Fetch(key, &our_value)) {
     o.Unpack(our_value);
   }
-  if (o.tick < our_tick_) {
-    o.dee = algo::formula_d(0, (double)our_tick_, o.dee, (double)o.tick);
-  }
-  if (std::abs(o.commits) < std::abs(v.commits))
-    o.commits = v.commits;
-  o.dee = (std::max)(o.dee, v.dee);
-  o.tick = max_tick_;
+  merge_value(&o, UserDbValue(value), our_tick_, their_tick_, max_tick_);
   return db_->Update(key, o.Pack()) && ++merged_entries_;
 }
 
@@ -238,6 +309,172 @@ void UserDbMerger::CloseMerge() {
   merged_entries_ = 0;
 }
 
+struct UserDbSnapshotMerger::Snapshot {
+  path file_path;
+  string user_id = "unknown";
+  TickCount tick = 0;
+  int num_entries = 0;
+  // tick counts of the db before and after merging this snapshot
+  TickCount our_tick = 0;
+  TickCount max_tick = 0;
+  // the current entry while merging
+  the<TsvSource> source;
+  string key;
+  string value;
+
+  bool exhausted() const { return !source; }
+  void Next() {
+    if (!source->Get(&key, &value))
+      source.reset();
+  }
+};
+
+UserDbSnapshotMerger::UserDbSnapshotMerger(Db* db) : db_(db) {}
+
+UserDbSnapshotMerger::~UserDbSnapshotMerger() {}
+
+bool UserDbSnapshotMerger::AddSnapshot(const path& snapshot_file) {
+  if (!db_)
+    return false;
+  TsvSource source(snapshot_file, plain_userdb_format.parser);
+  if (!source.is_open()) {
+    LOG(ERROR) << "error opening snapshot file: " << snapshot_file;
+    return false;
+  }
+  the<Snapshot> snapshot(new Snapshot);
+  snapshot->file_path = snapshot_file;
+  string key, value, db_type, db_name;
+  while (source.MetaGet(&key, &value)) {
+    if (key == "/db_type") {
+      db_type = value;
+    } else if (key == "/db_name") {
+      db_name = strip_userdb_extension(value);
+    } else if (key == "/user_id") {
+      snapshot->user_id = value;
+    } else if (key == "/tick") {
+      try {
+        snapshot->tick = std::stoul(value);
+      } catch (...) {
+      }
+    }
+  }
+  if (db_type != "userdb" || db_name != db_->name()) {
+    LOG(WARNING) << "not a snapshot of userdb '" << db_->name()
+                 << "': " << snapshot_file;
+    return false;
+  }
+  // entries are merged in the order of keys, as the db is read.
+  string last_key;
+  while (source.Get(&key, &value)) {
+    if (snapshot->num_entries > 0 && !(last_key < key)) {
+      LOG(WARNING) << "entries not in order at '" << key
+                   << "' in snapshot file: " << snapshot_file;
+      return false;
+    }
+    last_key.swap(key);
+    ++snapshot->num_entries;
+  }
+  snapshots_.push_back(std::move(snapshot));
+  return true;
+}
+
+int UserDbSnapshotMerger::Merge(ProgressCallback progress) {
+  if (!db_ || !db_->loaded())
+    return -1;
+  // the snapshots are merged as if one after another.
+  TickCount our_tick = get_tick_count(db_);
+  int total = 0;
+  for (auto& snapshot : snapshots_) {
+    snapshot->our_tick = our_tick;
+    snapshot->max_tick = (std::max)(our_tick, snapshot->tick);
+    if (snapshot->num_entries > 0)
+      our_tick = snapshot->max_tick;
+    total += snapshot->num_entries;
+    LOG(INFO) << "merging " << snapshot->num_entries << " entries from "
+              << snapshot->user_id << " into userdb '" << db_->name() << "'.";
+    snapshot->source.reset(
+        new TsvSource(snapshot->file_path, plain_userdb_format.parser));
+    string key, value;
+    while (snapshot->source->MetaGet(&key, &value)) {
+    }
+    snapshot->Next();
+  }
+  an<DbAccessor> ours = db_->QueryAll();
+  string our_key, our_value;
+  bool has_ours = ours && ours->GetNextRecord(&our_key, &our_value);
+  vector<pair<string, string>> batch;
+  int merged_entries = 0;
+  while (true) {
+    // there are only a few snapshots, one per device.
+    const Snapshot* next = nullptr;
+    for (const auto& snapshot : snapshots_) {
+      if (!snapshot->exhausted() && (!next || snapshot->key < next->key))
+        next = snapshot.get();
+    }
+    if (!next)
+      break;
+    string key = next->key;
+    while (has_ours && our_key < key) {
+      has_ours = ours->GetNextRecord(&our_key, &our_value);
+    }
+    UserDbValue o;
+    if (has_ours && our_key == key) {
+      o.Unpack(our_value);
+    }
+    for (auto& snapshot : snapshots_) {
+      if (snapshot->exhausted() || snapshot->key != key)
+        continue;
+      merge_value(&o, UserDbValue(snapshot->value), snapshot->our_tick,
+                  snapshot->tick, snapshot->max_tick);
+      snapshot->Next();
+      ++merged_entries;
+    }
+    batch.emplace_back(std::move(key), o.Pack());
+    if (batch.size() >= kBatchSize) {
+      if (!Write(batch))
+        return -1;
+      batch.clear();
+      if (progress)
+        progress(merged_entries, total);
+    }
+  }
+  if (!batch.empty() && !Write(batch))
+    return -1;
+  if (merged_entries > 0) {
+    Deployer& deployer(Service::instance().deployer());
+    if (!db_->MetaUpdate("/tick", std::to_string(our_tick)) ||
+        !db_->MetaUpdate("/user_id", deployer.user_id)) {
+      LOG(ERROR) << "failed to update tick count.";
+      return -1;
+    }
+  }
+  LOG(INFO) << "total " << merged_entries
+            << " entries merged, tick = " << our_tick;
+  if (progress)
+    progress(merged_entries, total);
+  return merged_entries;
+}
+
+bool UserDbSnapshotMerger::Write(const vector<pair<string, string>>& entries) {
+  auto* transactional = dynamic_cast<Transactional*>(db_);
+  bool in_transaction = transactional && transactional->BeginTransaction();
+  for (const auto& entry : entries) {
+    if (!db_->Update(entry.first, entry.second)) {
+      LOG(ERROR) << "error writing merged entries to userdb '" << db_->name()
+                 << "'.";
+      if (in_transaction)
+        transactional->AbortTransaction();
+      return false;
+    }
+  }
+  if (in_transaction && !transactional->CommitTransaction()) {
+    LOG(ERROR) << "error committing merged entries to userdb '"
+               << db_->name() << "'.";
+    return false;
+  }
+  return true;
+}
+
 UserDbImporter::UserDbImporter(Db* db) : db_(db) {}
 
 bool UserDbImporter::MetaPut(const string& key, const string& value) {
@@ -25,8 +25,16 @@ struct UserDbValue {
   UserDbValue() = default;
   UserDbValue(const string& value);
 
+  /// Packs the value in the compact binary format.
   string Pack() const;
+  /// Packs the value as a text record "c=<commits> d=<dee> t=<tick>",
+  /// the format of text user dbs and snapshots.
+  string PackText() const;
+  /// Unpacks a value in either format.
   bool Unpack(const string& value);
+
+  /// Tells if the value is in the binary format.
+  static bool IsPacked(const string& value);
 };
 
 /**
@@ -123,7 +131,39 @@ class UserDbMerger : public Sink {
   TickCount our_tick_;
   TickCount their_tick_;
   TickCount max_tick_;
-  int merged_entries_;
+  int merged_entries_ = 0;
+};
+
+/// Merges snapshots of a user db into the db in a single pass.
+///
+/// Snapshots are read along with the db in the order of keys, and merged
+/// entries are written in batches. The result is the same as merging the
+/// snapshots one after another with rime::UserDbMerger.
+class UserDbSnapshotMerger {
+ public:
+  /// Reports the number of snapshot entries merged so far and in total.
+  using ProgressCallback = function<void(int merged, int total)>;
+  /// Number of merged entries written in a transaction.
+  static constexpr size_t kBatchSize = 4096;
+
+  RIME_DLL explicit UserDbSnapshotMerger(Db* db);
+  RIME_DLL ~UserDbSnapshotMerger();
+
+  /// Scans a snapshot to merge. Returns false if it is not a snapshot of
+  /// the db, or its entries are not in the order of keys.
+  RIME_DLL bool AddSnapshot(const path& snapshot_file);
+  /// Returns the number of merged entries, or -1 on failure.
+  RIME_DLL int Merge(ProgressCallback progress = nullptr);
+
+  size_t num_snapshots() const { return snapshots_.size(); }
+
+ protected:
+  struct Snapshot;
+
+  bool Write(const vector<pair<string, string>>& entries);
+
+  Db* db_;
+  vector<the<Snapshot>> snapshots_;
 };
 
 class UserDbImporter : public Sink {
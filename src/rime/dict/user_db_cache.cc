@@ -0,0 +1,246 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <rime/algo/utilities.h>
+#include <rime/dict/user_db_cache.h>
+
+namespace rime {
+
+class UserDbCacheAccessor : public DbAccessor {
+ public:
+  UserDbCacheAccessor(std::shared_mutex& mutex,
+                      const map<string, string>& entries,
+                      const string& prefix)
+      : DbAccessor(prefix), lock_(mutex), entries_(entries) {
+    Reset();
+  }
+
+  bool Reset() override {
+    iter_ = prefix_.empty() ? entries_.begin() : entries_.lower_bound(prefix_);
+    return iter_ != entries_.end();
+  }
+  bool Jump(const string& key) override {
+    iter_ = entries_.lower_bound(key);
+    return iter_ != entries_.end();
+  }
+  bool GetNextRecord(string* key, string* value) override {
+    if (!key || !value || exhausted())
+      return false;
+    *key = iter_->first;
+    *value = iter_->second;
+    ++iter_;
+    return true;
+  }
+  bool exhausted() override {
+    return iter_ == entries_.end() || !MatchesPrefix(iter_->first);
+  }
+
+ private:
+  std::shared_lock<std::shared_mutex> lock_;
+  const map<string, string>& entries_;
+  map<string, string>::const_iterator iter_;
+};
+
+void UserDbUpdates::clear() {
+  entries.clear();
+  metadata.clear();
+}
+
+UserDbCache::UserDbCache(an<Db> db) : db_(db) {}
+
+UserDbCache::~UserDbCache() {
+#ifndef RIME_NO_THREADING
+  {
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    stopping_ = true;
+  }
+  flusher_cv_.notify_all();
+  if (flusher_.valid()) {
+    flusher_.wait();
+  }
+#endif
+  Flush();
+}
+
+bool UserDbCache::Load() {
+  std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!db_ || !db_->loaded())
+    return false;
+  auto accessor = db_->QueryAll();
+  if (!accessor)
+    return false;
+  entries_.clear();
+  unflushed_.clear();
+  string key, value;
+  // keys come in order, so each one is inserted at the end
+  while (accessor->GetNextRecord(&key, &value)) {
+    entries_.emplace_hint(entries_.end(), std::move(key), std::move(value));
+  }
+  LOG(INFO) << "cached " << entries_.size() << " entries of user db '"
+            << db_->name() << "'.";
+  loaded_ = true;
+  return true;
+}
+
+size_t UserDbCache::size() {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return entries_.size();
+}
+
+an<DbAccessor> UserDbCache::Query(const string& key) {
+  if (!loaded_)
+    return nullptr;
+  return New<UserDbCacheAccessor>(mutex_, entries_, key);
+}
+
+bool UserDbCache::Fetch(const string& key, string* value) {
+  if (!value || !loaded_)
+    return false;
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto found = entries_.find(key);
+  if (found == entries_.end())
+    return false;
+  *value = found->second;
+  return true;
+}
+
+bool UserDbCache::Update(const string& key, const string& value) {
+  UserDbUpdates updates;
+  updates.entries[key] = value;
+  return Commit(std::move(updates));
+}
+
+bool UserDbCache::MetaFetch(const string& key, string* value) {
+  if (!value)
+    return false;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto* updates : {&unflushed_, &flushing_}) {
+      auto found = updates->metadata.find(key);
+      if (found != updates->metadata.end()) {
+        *value = found->second;
+        return true;
+      }
+    }
+  }
+  return db_->MetaFetch(key, value);
+}
+
+bool UserDbCache::MetaUpdate(const string& key, const string& value) {
+  UserDbUpdates updates;
+  updates.metadata[key] = value;
+  return Commit(std::move(updates));
+}
+
+bool UserDbCache::Commit(UserDbUpdates updates) {
+  if (!db_ || db_->readonly())
+    return false;
+  if (updates.empty())
+    return true;
+  if (!loaded_) {
+    // Load() holds the lock as well, not to miss what is written through
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    if (!loaded_)
+      return Write(updates);
+  }
+  bool flush_now = false;
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& x : updates.entries) {
+      entries_[x.first] = x.second;
+      unflushed_.entries[x.first] = std::move(x.second);
+    }
+    for (auto& x : updates.metadata) {
+      unflushed_.metadata[x.first] = std::move(x.second);
+    }
+    flush_now = unflushed_.entries.size() >= kMaxUnflushedKeys;
+  }
+  ScheduleFlush(flush_now);
+  return true;
+}
+
+bool UserDbCache::Flush() {
+  std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (unflushed_.empty())
+      return true;
+    flushing_ = std::move(unflushed_);
+    unflushed_.clear();
+  }
+  bool success = Write(flushing_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!success) {
+    // retry with the next flush, unless they have been updated since
+    unflushed_.entries.merge(flushing_.entries);
+    unflushed_.metadata.merge(flushing_.metadata);
+  }
+  flushing_.clear();
+  return success;
+}
+
+bool UserDbCache::Write(const UserDbUpdates& updates) {
+  if (!db_->loaded() || db_->readonly())
+    return false;
+  auto db = As<Transactional>(db_);
+  bool batched = db && !db->in_transaction() && db->BeginTransaction();
+  bool success = true;
+  for (const auto& x : updates.entries) {
+    success = db_->Update(x.first, x.second) && success;
+  }
+  for (const auto& x : updates.metadata) {
+    success = db_->MetaUpdate(x.first, x.second) && success;
+  }
+  if (batched) {
+    success = db->CommitTransaction() && success;
+  }
+  if (success) {
+    DLOG(INFO) << "flushed " << updates.entries.size() << " entries to db '"
+               << db_->name() << "'.";
+  } else {
+    LOG(ERROR) << "failed to write updates to db '" << db_->name() << "'.";
+  }
+  return success;
+}
+
+void UserDbCache::ScheduleFlush(bool now) {
+#ifdef RIME_NO_THREADING
+  // without a thread to write behind, write through.
+  Flush();
+#else
+  {
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    last_commit_ = std::chrono::steady_clock::now();
+    flush_scheduled_ = true;
+    flush_now_ = flush_now_ || now;
+    if (!flusher_.valid()) {
+      flusher_ = RunAsync([this] { RunFlusher(); });
+    }
+  }
+  flusher_cv_.notify_one();
+#endif
+}
+
+void UserDbCache::RunFlusher() {
+  std::unique_lock<std::mutex> lock(flusher_mutex_);
+  while (!stopping_) {
+    if (!flush_scheduled_) {
+      flusher_cv_.wait(lock);
+      continue;
+    }
+    auto idle_until = last_commit_ + kFlushIdleTime;
+    if (!flush_now_ && std::chrono::steady_clock::now() < idle_until) {
+      flusher_cv_.wait_until(lock, idle_until);
+      continue;
+    }
+    flush_scheduled_ = false;
+    flush_now_ = false;
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+}  // namespace rime
@@ -0,0 +1,90 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#ifndef RIME_USER_DB_CACHE_H_
+#define RIME_USER_DB_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <rime_api.h>
+#include <rime/common.h>
+#include <rime/dict/db.h>
+
+namespace rime {
+
+// updates to entries and metadata of a user db, applied together.
+struct UserDbUpdates {
+  map<string, string> entries;
+  map<string, string> metadata;
+
+  bool empty() const { return entries.empty() && metadata.empty(); }
+  void clear();
+};
+
+// an in-memory copy of the entries of a user db, in the same order of keys.
+// lookups are served from memory while updates are written behind to the db,
+// which remains the durable store.
+// shared by user dictionaries of the same db in different sessions, which
+// write to the db through the cache, even before it is loaded.
+class RIME_DLL UserDbCache {
+ public:
+  // committed updates are written to the db once no more commits come in
+  // for this long, or once this many keys are waiting to be written.
+  static constexpr std::chrono::seconds kFlushIdleTime{5};
+  static constexpr size_t kMaxUnflushedKeys = 256;
+
+  explicit UserDbCache(an<Db> db);
+  ~UserDbCache();
+
+  // reads all entries from the db.
+  bool Load();
+  bool loaded() const { return loaded_; }
+  size_t size();
+
+  // accessors keep the cache from being updated until they are released.
+  an<DbAccessor> Query(const string& key);
+  bool Fetch(const string& key, string* value);
+  bool Update(const string& key, const string& value);
+  bool MetaFetch(const string& key, string* value);
+  bool MetaUpdate(const string& key, const string& value);
+  // applies updates at once, such as those of a transaction of a user
+  // dictionary. written through to the db if the cache is not loaded.
+  bool Commit(UserDbUpdates updates);
+
+  // writes committed updates to the db as one batch.
+  bool Flush();
+
+ private:
+  bool Write(const UserDbUpdates& updates);
+  void ScheduleFlush(bool now);
+  void RunFlusher();
+
+  an<Db> db_;
+  // read by sessions without locking, as it is only ever set once
+  std::atomic<bool> loaded_{false};
+  std::shared_mutex mutex_;
+  map<string, string> entries_;
+  // committed updates yet to be written to the db
+  UserDbUpdates unflushed_;
+  // updates being written to the db
+  UserDbUpdates flushing_;
+  // one write to the db at a time, as its transaction is shared
+  std::mutex flush_mutex_;
+
+  std::mutex flusher_mutex_;
+  std::condition_variable flusher_cv_;
+  std::future<void> flusher_;
+  std::chrono::steady_clock::time_point last_commit_;
+  bool flush_scheduled_ = false;
+  bool flush_now_ = false;
+  bool stopping_ = false;
+};
+
+}  // namespace rime
+
+#endif  // RIME_USER_DB_CACHE_H_
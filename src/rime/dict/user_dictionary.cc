@@ -19,6 +19,8 @@
 #include <rime/algo/strings.h>
 #include <rime/dict/db.h>
 #include <rime/dict/table.h>
+#include <rime/dict/text_db.h>
+#include <rime/dict/user_db_cache.h>
 #include <rime/dict/user_dictionary.h>
 #include <rime/dict/vocabulary.h>
 
@@ -115,14 +117,29 @@ void UserDictEntryIterator::SortRange(size_t start, size_t count) {
 }
 
 void UserDictEntryIterator::AddFilter(DictEntryFilter filter) {
-  DictEntryFilterBinder::AddFilter(filter);
+  DictEntryFilterBinder::AddFilter(std::move(filter));
+  SkipFilteredEntries();
+}
+
+void UserDictEntryIterator::AddFilter(DictEntryViewFilter filter) {
+  DictEntryFilterBinder::AddFilter(std::move(filter));
+  SkipFilteredEntries();
+}
+
+void UserDictEntryIterator::SkipFilteredEntries() {
   // the introduced filter could invalidate the current or even all the
   // remaining entries
-  while (!exhausted() && !filter_(Peek())) {
+  while (!exhausted() && !PassesFilters()) {
     FindNextEntry();
   }
 }
 
+bool UserDictEntryIterator::PassesFilters() {
+  const auto& entry = cache_[index_];
+  return (!view_filter_ || view_filter_(*entry)) &&
+         (!filter_ || filter_(entry));
+}
+
 an<DictEntry> UserDictEntryIterator::Peek() {
   if (exhausted()) {
     return nullptr;
@@ -142,7 +159,7 @@ bool UserDictEntryIterator::Next() {
   if (!FindNextEntry()) {
     return false;
   }
-  while (filter_ && !filter_(Peek())) {
+  while (!PassesFilters()) {
     if (!FindNextEntry()) {
       return false;
     }
@@ -152,12 +169,17 @@ bool UserDictEntryIterator::Next() {
 
 // UserDictionary members
 
-UserDictionary::UserDictionary(const string& name, an<Db> db)
-    : name_(name), db_(db) {}
+UserDictionary::UserDictionary(const string& name,
+                               an<Db> db,
+                               an<UserDbCache> cache)
+    : name_(name), db_(db), cache_(cache) {}
 
 UserDictionary::~UserDictionary() {
   if (loaded()) {
     CommitPendingTransaction();
+    // write behind what the session has learned as it ends
+    if (cache_)
+      cache_->Flush();
   }
 }
 
@@ -167,7 +189,12 @@ void UserDictionary::Attach(const an<Table>& table, const an<Prism>& prism) {
 }
 
 bool UserDictionary::Load() {
-  if (!db_ || db_->disabled())
+  if (!db_)
+    return false;
+  // user dbs are shared by dictionaries in different sessions;
+  // each is locked on its own, so reading one does not block the others.
+  std::lock_guard<std::mutex> lock(db_->load_mutex());
+  if (db_->disabled())
     return false;
   if (!db_->loaded() && !db_->Open()) {
     // try to recover managed db in available work thread
@@ -179,7 +206,12 @@ bool UserDictionary::Load() {
     }
     return false;
   }
-  return FetchTickCount() || Initialize();
+  if (!FetchTickCount() && !Initialize())
+    return false;
+  if (cache_ && !cache_->loaded() && !cache_->Load()) {
+    LOG(WARNING) << "failed to cache user db '" << name_ << "'.";
+  }
+  return true;
 }
 
 bool UserDictionary::loaded() const {
@@ -218,24 +250,24 @@ void UserDictionary::DfsLookup(const SyllableGraph& syll_graph,
                                const string& current_prefix,
                                DfsState* state) {
   auto index = syll_graph.indices.find(current_pos);
-  if (index == syll_graph.indices.end()) {
+  if (!index) {
     return;
   }
   DLOG(INFO) << "dfs lookup starts from " << current_pos;
   string prefix;
-  for (const auto& spelling : index->second) {
+  for (const auto& spelling : *index) {
     DLOG(INFO) << "prefix: '" << current_prefix << "'"
-               << ", syll_id: " << spelling.first
-               << ", num_spellings: " << spelling.second.size();
-    state->code.push_back(spelling.first);
+               << ", syll_id: " << spelling.syllable_id
+               << ", num_spellings: " << spelling.spellings.size();
+    state->code.push_back(spelling.syllable_id);
     BOOST_SCOPE_EXIT((&state)) {
       state->code.pop_back();
     }
     BOOST_SCOPE_EXIT_END
     if (!TranslateCodeToString(state->code, &prefix))
       continue;
-    for (size_t i = 0; i < spelling.second.size(); ++i) {
-      auto props = spelling.second[i];
+    for (size_t i = 0; i < spelling.spellings.size(); ++i) {
+      auto props = spelling.spellings[i];
       if (i > 0 && props->type >= kAbbreviation)
         continue;
       state->credibility.push_back(state->credibility.back() +
@@ -265,7 +297,7 @@ void UserDictionary::DfsLookup(const SyllableGraph& syll_graph,
           break;
       }
       auto next_index = syll_graph.indices.find(end_pos);
-      if (next_index == syll_graph.indices.end()) {
+      if (!next_index) {
         // reached the end of input, predict word if requested
         if (state->predict_word_from_depth != 0 &&
             state->depth() >= state->predict_word_from_depth) {
@@ -327,7 +359,7 @@ an<UserDictEntryCollector> UserDictionary::Lookup(
   state.present_tick = tick_ + 1;
   state.credibility.push_back(initial_credibility);
   state.quality_len.push_back(0.0);
-  state.accessor = db_->Query("");
+  state.accessor = Query("");
   state.accessor->Jump(" ");  // skip metadata
   string prefix;
   DfsLookup(syll_graph, start_pos, prefix, &state);
@@ -369,7 +401,7 @@ size_t UserDictionary::LookupWords(UserDictEntryIterator* result,
   string key;
   string value;
   string full_code;
-  auto accessor = db_->Query(input);
+  auto accessor = Query(input);
   if (!accessor || accessor->exhausted()) {
     if (resume_key)
       *resume_key = kEnd;
@@ -431,7 +463,7 @@ bool UserDictionary::UpdateEntry(const DictEntry& entry,
   string key(code_str + '\t' + entry.text);
   string value;
   UserDbValue v;
-  if (db_->Fetch(key, &value)) {
+  if (Fetch(key, &value)) {
     v.Unpack(value);
     if (v.tick > tick_) {
       v.tick = tick_;  // fix abnormal timestamp
@@ -453,27 +485,27 @@ bool UserDictionary::UpdateEntry(const DictEntry& entry,
     v.dee = algo::formula_d(0.0, (double)tick_, v.dee, (double)v.tick);
   }
   v.tick = tick_;
-  return db_->Update(key, v.Pack());
+  return Update(key, v.Pack());
 }
 
 bool UserDictionary::UpdateTickCount(TickCount increment) {
   tick_ += increment;
   try {
-    return db_->MetaUpdate("/tick", std::to_string(tick_));
+    return MetaUpdate("/tick", std::to_string(tick_));
   } catch (...) {
     return false;
   }
 }
 
 bool UserDictionary::Initialize() {
-  return db_->MetaUpdate("/tick", "0");
+  return MetaUpdate("/tick", "0");
 }
 
 bool UserDictionary::FetchTickCount() {
   string value;
   try {
     // an earlier version mistakenly wrote tick count into an empty key
-    if (!db_->MetaFetch("/tick", &value) && !db_->Fetch("", &value))
+    if (!MetaFetch("/tick", &value) && !db_->Fetch("", &value))
       return false;
     tick_ = std::stoul(value);
     return true;
@@ -484,29 +516,105 @@ bool UserDictionary::FetchTickCount() {
 }
 
 bool UserDictionary::NewTransaction() {
-  auto db = As<Transactional>(db_);
-  if (!db)
+  if (!loaded())
     return false;
   CommitPendingTransaction();
   transaction_time_ = time(NULL);
-  return db->BeginTransaction();
+  in_transaction_ = true;
+  return true;
 }
 
 bool UserDictionary::RevertRecentTransaction() {
-  auto db = As<Transactional>(db_);
-  if (!db || !db->in_transaction())
+  if (!in_transaction_)
     return false;
   if (time(NULL) - transaction_time_ > 3 /*seconds*/)
     return false;
-  return db->AbortTransaction();
+  in_transaction_ = false;
+  pending_.clear();
+  ++pending_generation_;
+  return true;
 }
 
 bool UserDictionary::CommitPendingTransaction() {
-  auto db = As<Transactional>(db_);
-  if (db && db->in_transaction()) {
-    return db->CommitTransaction();
+  if (!in_transaction_)
+    return false;
+  in_transaction_ = false;
+  UserDbUpdates updates;
+  std::swap(updates, pending_);
+  return Write(std::move(updates));
+}
+
+// entries are read from the cache once it is loaded, while all updates to
+// a cached db are written through the cache.
+
+bool UserDictionary::cached() const {
+  return cache_ && cache_->loaded();
+}
+
+an<DbAccessor> UserDictionary::Query(const string& key) {
+  return cached() ? cache_->Query(key) : db_->Query(key);
+}
+
+bool UserDictionary::Fetch(const string& key, string* value) {
+  if (in_transaction_) {
+    auto found = pending_.entries.find(key);
+    if (found != pending_.entries.end()) {
+      *value = found->second;
+      return true;
+    }
+  }
+  return cached() ? cache_->Fetch(key, value) : db_->Fetch(key, value);
+}
+
+bool UserDictionary::Update(const string& key, const string& value) {
+  if (in_transaction_) {
+    pending_.entries[key] = value;
+    ++pending_generation_;
+    return true;
+  }
+  bool success =
+      cache_ ? cache_->Update(key, value) : db_->Update(key, value);
+  db_->bump_generation();
+  return success;
+}
+
+bool UserDictionary::MetaFetch(const string& key, string* value) {
+  if (in_transaction_) {
+    auto found = pending_.metadata.find(key);
+    if (found != pending_.metadata.end()) {
+      *value = found->second;
+      return true;
+    }
+  }
+  return cache_ ? cache_->MetaFetch(key, value) : db_->MetaFetch(key, value);
+}
+
+bool UserDictionary::MetaUpdate(const string& key, const string& value) {
+  if (in_transaction_) {
+    pending_.metadata[key] = value;
+    ++pending_generation_;
+    return true;
+  }
+  bool success = cache_ ? cache_->MetaUpdate(key, value)
+                        : db_->MetaUpdate(key, value);
+  db_->bump_generation();
+  return success;
+}
+
+bool UserDictionary::Write(UserDbUpdates updates) {
+  bool success = true;
+  if (cache_) {
+    success = cache_->Commit(std::move(updates));
+  } else {
+    for (const auto& x : updates.entries) {
+      success = db_->Update(x.first, x.second) && success;
+    }
+    for (const auto& x : updates.metadata) {
+      success = db_->MetaUpdate(x.first, x.second) && success;
+    }
   }
-  return false;
+  db_->bump_generation();
+  return success;
 }
 
 bool UserDictionary::TranslateCodeToString(const Code& code, string* result) {
@@ -572,6 +680,7 @@ UserDictionaryComponent::UserDictionaryComponent() {}
 
 UserDictionary* UserDictionaryComponent::Create(const string& dict_name,
                                                 const string& db_class) {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto db = db_pool_[dict_name].lock();
   if (!db) {
     auto component = Db::Require(db_class);
@@ -582,7 +691,13 @@ UserDictionary* UserDictionaryComponent::Create(const string& dict_name,
     db.reset(component->Create(dict_name));
     db_pool_[dict_name] = db;
   }
-  return new UserDictionary(dict_name, db);
+  // text dbs are already kept in memory
+  auto cache = cache_pool_[dict_name].lock();
+  if (!cache && !Is<TextDb>(db)) {
+    cache = New<UserDbCache>(db);
+    cache_pool_[dict_name] = cache;
+  }
+  return new UserDictionary(dict_name, db, cache);
 }
 
 UserDictionary* UserDictionaryComponent::Create(const Ticket& ticket) {
@@ -8,9 +8,11 @@
 #define RIME_USER_DICTIONARY_H_
 
 #include <time.h>
+#include <mutex>
 #include <rime/common.h>
 #include <rime/component.h>
 #include <rime/dict/user_db.h>
+#include <rime/dict/user_db_cache.h>
 #include <rime/dict/vocabulary.h>
 
 namespace rime {
@@ -24,6 +26,7 @@ class UserDictEntryIterator : public DictEntryFilterBinder {
   void SortRange(size_t start, size_t count);
 
   void AddFilter(DictEntryFilter filter) override;
+  void AddFilter(DictEntryViewFilter filter) override;
   an<DictEntry> Peek();
   bool Next();
   bool exhausted() const { return index_ >= cache_.size(); }
@@ -31,6 +34,8 @@ class UserDictEntryIterator : public DictEntryFilterBinder {
 
  protected:
   bool FindNextEntry();
+  bool PassesFilters();
+  void SkipFilteredEntries();
 
   DictEntryList cache_;
   size_t index_ = 0;
@@ -42,13 +47,16 @@ class Schema;
 class Table;
 class Prism;
 class Db;
+class DbAccessor;
 struct SyllableGraph;
 struct DfsState;
 struct Ticket;
 
 class UserDictionary : public Class<UserDictionary, const Ticket&> {
  public:
-  UserDictionary(const string& name, an<Db> db);
+  UserDictionary(const string& name,
+                 an<Db> db,
+                 an<UserDbCache> cache = nullptr);
   virtual ~UserDictionary();
 
   void Attach(const an<Table>& table, const an<Prism>& prism);
@@ -78,6 +86,11 @@ class UserDictionary : public Class<UserDictionary, const Ticket&> {
 
   const string& name() const { return name_; }
   TickCount tick() const { return tick_; }
+  // changes with every update, committed by any session or pending in
+  // this one.
+  uint64_t generation() const {
+    return (db_ ? db_->generation() : 0) + pending_generation_;
+  }
 
   static an<DictEntry> CreateDictEntry(const string& key,
                                        const string& value,
@@ -90,6 +103,14 @@ class UserDictionary : public Class<UserDictionary, const Ticket&> {
   bool Initialize();
   bool FetchTickCount();
   bool TranslateCodeToString(const Code& code, string* result);
+  // access entries through the cache if it is loaded.
+  an<DbAccessor> Query(const string& key);
+  bool Fetch(const string& key, string* value);
+  bool Update(const string& key, const string& value);
+  bool MetaFetch(const string& key, string* value);
+  bool MetaUpdate(const string& key, const string& value);
+  bool Write(UserDbUpdates updates);
+  bool cached() const;
   void DfsLookup(const SyllableGraph& syll_graph,
                  size_t current_pos,
                  const string& current_prefix,
@@ -98,11 +119,17 @@ class UserDictionary : public Class<UserDictionary, const Ticket&> {
  private:
   string name_;
   an<Db> db_;
+  an<UserDbCache> cache_;
   an<Table> table_;
   an<Prism> prism_;
   hash_map<string, SyllableId> syllabary_;
   hash_map<SyllableId, string> rev_syllabary_;
   TickCount tick_ = 0;
+  // the user db is shared with other sessions, so each dictionary keeps
+  // updates of its own transaction until committed.
+  bool in_transaction_ = false;
+  UserDbUpdates pending_;
+  uint64_t pending_generation_ = 0;
   time_t transaction_time_ = 0;
 };
 
@@ -113,7 +140,9 @@ class UserDictionaryComponent : public UserDictionary::Component {
   UserDictionary* Create(const string& dict_name, const string& db_class);
 
  private:
+  std::mutex mutex_;
   hash_map<string, weak<Db>> db_pool_;
+  hash_map<string, weak<UserDbCache>> cache_pool_;
 };
 
 }  // namespace rime
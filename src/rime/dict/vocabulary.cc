@@ -109,17 +109,26 @@ void DictEntryList::SortRange(size_t start, size_t count) {
   sort_range(*this, start, count);
 }
 
-void DictEntryFilterBinder::AddFilter(DictEntryFilter filter) {
-  if (!filter_) {
-    filter_.swap(filter);
+template <class Filter>
+static void chain_filter(Filter* chain, Filter filter) {
+  if (!*chain) {
+    chain->swap(filter);
   } else {
-    DictEntryFilter previous_filter(std::move(filter_));
-    filter_ = [previous_filter, filter](an<DictEntry> e) {
+    Filter previous_filter(std::move(*chain));
+    *chain = [previous_filter, filter](const auto& e) {
       return previous_filter(e) && filter(e);
     };
   }
 }
 
+void DictEntryFilterBinder::AddFilter(DictEntryFilter filter) {
+  chain_filter(&filter_, std::move(filter));
+}
+
+void DictEntryFilterBinder::AddFilter(DictEntryViewFilter filter) {
+  chain_filter(&view_filter_, std::move(filter));
+}
+
 ShortDictEntryList* Vocabulary::LocateEntries(const Code& code) {
   Vocabulary* v = this;
   size_t n = code.size();
@@ -9,6 +9,7 @@
 #define RIME_VOCABULARY_H_
 
 #include <stdint.h>
+#include <string_view>
 #include <rime_api.h>
 #include <rime/common.h>
 
@@ -79,15 +80,35 @@ class DictEntryList : public vector<of<DictEntry>> {
   void SortRange(size_t start, size_t count);
 };
 
+// a light-weight view of dict entry data, passed to filters before the
+// entry is materialized as a DictEntry object.
+// referenced data is valid until the source iterator moves on.
+struct DictEntryView {
+  std::string_view text;
+  const Code* code = nullptr;
+  double weight = 0.0;
+
+  DictEntryView() = default;
+  DictEntryView(std::string_view t, const Code* c, double w)
+      : text(t), code(c), weight(w) {}
+  DictEntryView(const DictEntry& entry)
+      : text(entry.text), code(&entry.code), weight(entry.weight) {}
+};
+
 using DictEntryFilter = function<bool(an<DictEntry> entry)>;
+using DictEntryViewFilter = function<bool(const DictEntryView& entry)>;
 
 class RIME_DLL DictEntryFilterBinder {
  public:
   virtual ~DictEntryFilterBinder() = default;
   virtual void AddFilter(DictEntryFilter filter);
+  // filters of views are tested first, and entries they reject are never
+  // materialized.
+  virtual void AddFilter(DictEntryViewFilter filter);
 
  protected:
   DictEntryFilter filter_;
+  DictEntryViewFilter view_filter_;
 };
 
 class Vocabulary;
@@ -21,6 +21,7 @@
 #include <rime/switches.h>
 #include <rime/ticket.h>
 #include <rime/translation.h>
+#include <rime/translation_cache.h>
 #include <rime/translator.h>
 
 namespace rime {
@@ -30,6 +31,7 @@ class ConcreteEngine : public Engine {
   ConcreteEngine();
   virtual ~ConcreteEngine();
   virtual bool ProcessKey(const KeyEvent& key_event);
+  virtual bool ProcessKeys(const KeySequence& keys);
   virtual void ApplySchema(Schema* schema);
   virtual void CommitText(string text);
   virtual void Compose(Context* ctx);
@@ -38,7 +40,10 @@ class ConcreteEngine : public Engine {
   void InitializeComponents();
   void InitializeOptions();
   void CalculateSegmentation(Segmentation* segments);
-  void TranslateSegments(Segmentation* segments);
+  void TranslateSegments(Composition* comp);
+  void TranslateSegment(const string& input, Segment* segment, Menu* menu);
+  bool TranslatorsCacheable() const;
+  uint64_t TranslatorsGeneration() const;
   void FormatText(string* text);
   void OnCommit(Context* ctx);
   void OnSelect(Context* ctx);
@@ -53,6 +58,10 @@ class ConcreteEngine : public Engine {
   vector<of<Formatter>> formatters_;
   vector<of<Processor>> post_processors_;
   an<Switcher> switcher_;
+  // whether to translate segments only when their candidates are requested
+  bool defer_translation_ = false;
+  // observed by deferred translations, which must not run past the engine.
+  an<bool> alive_ = New<bool>(true);
 };
 
 // implementations
@@ -61,9 +70,40 @@ Engine* Engine::Create() {
   return new ConcreteEngine;
 }
 
-Engine::Engine() : schema_(new Schema), context_(new Context) {}
+Engine::Engine()
+    : schema_(new Schema),
+      context_(new Context),
+      translation_cache_(new TranslationCache) {}
+
+bool Engine::ProcessKeys(const KeySequence& keys) {
+  bool accepted = true;
+  for (const KeyEvent& key_event : keys) {
+    if (!ProcessKey(key_event))
+      accepted = false;
+  }
+  return accepted;
+}
+
+void Engine::Post(function<void()> task) {
+  std::lock_guard<std::mutex> lock(posted_tasks_mutex_);
+  posted_tasks_.push_back(std::move(task));
+}
+
+void Engine::RunPostedTasks() {
+  vector<function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(posted_tasks_mutex_);
+    if (posted_tasks_.empty())
+      return;
+    tasks.swap(posted_tasks_);
+  }
+  for (auto& task : tasks) {
+    task();
+  }
+}
 
 Engine::~Engine() {
+  translation_cache_.reset();
   context_.reset();
   schema_.reset();
 }
@@ -75,6 +115,10 @@ ConcreteEngine::ConcreteEngine() {
   context_->select_notifier().connect([this](Context* ctx) { OnSelect(ctx); });
   context_->update_notifier().connect(
       [this](Context* ctx) { OnContextUpdate(ctx); });
+  // connected before translators, which recompose once they have deleted
+  // the entry from their dictionaries.
+  context_->delete_notifier().connect(
+      [this](Context* ctx) { translation_cache_->Clear(); });
   context_->option_update_notifier().connect(
       [this](Context* ctx, const string& option) {
         OnOptionUpdate(ctx, option);
@@ -93,11 +137,14 @@ ConcreteEngine::ConcreteEngine() {
 }
 
 ConcreteEngine::~ConcreteEngine() {
+  LOG(INFO) << "translation cache hits: " << translation_cache_->hits()
+            << ", misses: " << translation_cache_->misses();
   LOG(INFO) << "engine disposed.";
 }
 
 bool ConcreteEngine::ProcessKey(const KeyEvent& key_event) {
   DLOG(INFO) << "process key: " << key_event;
+  RunPostedTasks();
   ProcessResult ret = kNoop;
   for (auto& processor : processors_) {
     ret = processor->ProcessKeyEvent(key_event);
@@ -108,6 +155,8 @@ bool ConcreteEngine::ProcessKey(const KeyEvent& key_event) {
   }
   // record unhandled keys, eg. spaces, numbers, bksp's.
   context_->commit_history().Push(key_event);
+  // translations may depend on commit history
+  translation_cache_->Clear();
   // post-processing
   for (auto& processor : post_processors_) {
     ret = processor->ProcessKeyEvent(key_event);
@@ -121,6 +170,15 @@ bool ConcreteEngine::ProcessKey(const KeyEvent& key_event) {
   return false;
 }
 
+bool ConcreteEngine::ProcessKeys(const KeySequence& keys) {
+  // intermediate states are not observed, unless by processors.
+  bool deferring = defer_translation_;
+  defer_translation_ = true;
+  bool accepted = Engine::ProcessKeys(keys);
+  defer_translation_ = deferring;
+  return accepted;
+}
+
 void ConcreteEngine::OnContextUpdate(Context* ctx) {
   if (!ctx)
     return;
@@ -145,6 +203,7 @@ void ConcreteEngine::OnPropertyUpdate(Context* ctx, const string& property) {
   if (!ctx)
     return;
   LOG(INFO) << "updated property: " << property;
+  translation_cache_->Clear();
   // notification
   string value = ctx->get_property(property);
   string msg(property + "=" + value);
@@ -154,6 +213,7 @@ void ConcreteEngine::OnPropertyUpdate(Context* ctx, const string& property) {
 void ConcreteEngine::Compose(Context* ctx) {
   if (!ctx)
     return;
+  RunPostedTasks();
   Composition& comp = ctx->composition();
   const string active_input = ctx->input().substr(0, ctx->caret_pos());
   DLOG(INFO) << "active input: " << active_input;
@@ -200,38 +260,106 @@ void ConcreteEngine::CalculateSegmentation(Segmentation* segments) {
     segments->Forward();
 }
 
-void ConcreteEngine::TranslateSegments(Segmentation* segments) {
-  DLOG(INFO) << "TranslateSegments: " << *segments;
-  for (Segment& segment : *segments) {
+void ConcreteEngine::TranslateSegments(Composition* comp) {
+  DLOG(INFO) << "TranslateSegments: " << *comp;
+  for (Segment& segment : *comp) {
     DLOG(INFO) << "segment [" << segment.start << ", " << segment.end
                << "), status: " << segment.status;
     if (segment.status >= Segment::kGuess)
       continue;
     size_t len = segment.end - segment.start;
-    string input = segments->input().substr(segment.start, len);
-    DLOG(INFO) << "translating segment: [" << input << "]";
-    auto menu = New<Menu>();
-    for (auto& translator : translators_) {
-      auto translation = translator->Query(input, segment);
-      if (!translation)
-        continue;
-      if (translation->exhausted()) {
-        DLOG(INFO) << translator->name_space() << " made a futile translation.";
-        continue;
-      }
-      menu->AddTranslation(translation);
-    }
-    for (auto& filter : filters_) {
-      if (filter->AppliesToSegment(&segment)) {
-        menu->AddFilter(filter.get());
-      }
+    string input = comp->input().substr(segment.start, len);
+    size_t caret = std::min(std::max(context_->caret_pos(), segment.start),
+                            segment.end);
+    TranslationCacheKey key{segment.start,
+                            input,
+                            segment.tags,
+                            segment.end == context_->input().length(),
+                            comp->GetTextBefore(segment.start),
+                            context_->options(),
+                            caret - segment.start,
+                            TranslatorsGeneration()};
+    bool cacheable = TranslatorsCacheable();
+    auto menu = cacheable ? translation_cache_->Find(key, &segment) : nullptr;
+    if (menu) {
+      DLOG(INFO) << "reusing translation of segment: [" << input << "]";
+      segment.menu = menu;
+    } else if (defer_translation_) {
+      menu = New<Menu>();
+      Segment pending(segment);
+      pending.menu.reset();
+      // the menu may outlive the engine, or be populated after the
+      // composition has changed; everything needed is captured by value.
+      weak<bool> alive = alive_;
+      menu->Defer([this, alive, input, pending, cacheable,
+                   key = std::move(key)](Menu* menu) mutable {
+        if (alive.expired())
+          return;
+        TranslateSegment(input, &pending, menu);
+        Composition& comp = context_->composition();
+        for (Segment& segment : comp) {
+          if (segment.menu.get() != menu)
+            continue;
+          if (segment.start != pending.start || segment.end != pending.end ||
+              comp.input().compare(segment.start, segment.end - segment.start,
+                                   input) != 0)
+            break;
+          segment.prompt = pending.prompt;
+          if (cacheable)
+            translation_cache_->Insert(std::move(key), segment);
+          break;
+        }
+      });
+      segment.menu = menu;
+    } else {
+      menu = New<Menu>();
+      TranslateSegment(input, &segment, menu.get());
+      segment.menu = menu;
+      if (cacheable)
+        translation_cache_->Insert(std::move(key), segment);
     }
     segment.status = Segment::kGuess;
-    segment.menu = menu;
     segment.selected_index = 0;
   }
 }
 
+void ConcreteEngine::TranslateSegment(const string& input,
+                                      Segment* segment,
+                                      Menu* menu) {
+  DLOG(INFO) << "translating segment: [" << input << "]";
+  for (auto& translator : translators_) {
+    auto translation = translator->Query(input, *segment);
+    if (!translation)
+      continue;
+    if (translation->exhausted()) {
+      DLOG(INFO) << translator->name_space() << " made a futile translation.";
+      continue;
+    }
+    menu->AddTranslation(translation);
+  }
+  for (auto& filter : filters_) {
+    if (filter->AppliesToSegment(segment)) {
+      menu->AddFilter(filter.get());
+    }
+  }
+}
+
+bool ConcreteEngine::TranslatorsCacheable() const {
+  for (const auto& translator : translators_) {
+    if (!translator->cacheable())
+      return false;
+  }
+  return true;
+}
+
+uint64_t ConcreteEngine::TranslatorsGeneration() const {
+  uint64_t generation = 0;
+  for (const auto& translator : translators_) {
+    generation += translator->generation();
+  }
+  return generation;
+}
+
 void ConcreteEngine::FormatText(string* text) {
   if (formatters_.empty())
     return;
@@ -243,6 +371,7 @@ void ConcreteEngine::FormatText(string* text) {
 
 void ConcreteEngine::CommitText(string text) {
   context_->commit_history().Push(CommitRecord{"raw", text});
+  translation_cache_->Clear();
   FormatText(&text);
   DLOG(INFO) << "committing text: " << text;
   sink_(text);
@@ -250,6 +379,7 @@ void ConcreteEngine::CommitText(string text) {
 
 void ConcreteEngine::OnCommit(Context* ctx) {
   context_->commit_history().Push(ctx->composition(), ctx->input());
+  translation_cache_->Clear();
   string text = ctx->GetCommitText();
   FormatText(&text);
   DLOG(INFO) << "committing composition: " << text;
@@ -326,6 +456,8 @@ inline void CreateComponentsFromList(Engine* engine,
 }
 
 void ConcreteEngine::InitializeComponents() {
+  // cached menus refer to the filters
+  translation_cache_->Clear();
   processors_.clear();
   segmentors_.clear();
   translators_.clear();
@@ -7,6 +7,7 @@
 #ifndef RIME_ENGINE_H_
 #define RIME_ENGINE_H_
 
+#include <mutex>
 #include <rime_api.h>
 #include <rime/common.h>
 #include <rime/messenger.h>
@@ -14,8 +15,10 @@
 namespace rime {
 
 class KeyEvent;
+class KeySequence;
 class Schema;
 class Context;
+class TranslationCache;
 
 class Engine : public Messenger {
  public:
@@ -23,6 +26,8 @@ class Engine : public Messenger {
 
   virtual ~Engine();
   virtual bool ProcessKey(const KeyEvent& key_event) { return false; }
+  // returns true if every key is accepted.
+  RIME_DLL virtual bool ProcessKeys(const KeySequence& keys);
   virtual void ApplySchema(Schema* schema) {}
   virtual void CommitText(string text) { sink_(text); }
   virtual void Compose(Context* ctx) {}
@@ -30,6 +35,13 @@ class Engine : public Messenger {
   Schema* schema() const { return schema_.get(); }
   Context* context() const { return context_.get(); }
   CommitSink& sink() { return sink_; }
+  TranslationCache* translation_cache() const {
+    return translation_cache_.get();
+  }
+
+  // runs a task on the engine's thread before it next processes a key or
+  // composes. can be called from any thread.
+  RIME_DLL void Post(function<void()> task);
 
   Engine* active_engine() { return active_engine_ ? active_engine_ : this; }
   void set_active_engine(Engine* engine = nullptr) { active_engine_ = engine; }
@@ -39,10 +51,17 @@ class Engine : public Messenger {
  protected:
   Engine();
 
+  void RunPostedTasks();
+
   the<Schema> schema_;
   the<Context> context_;
+  the<TranslationCache> translation_cache_;
   CommitSink sink_;
   Engine* active_engine_ = nullptr;
+
+ private:
+  std::mutex posted_tasks_mutex_;
+  vector<function<void()>> posted_tasks_;
 };
 
 }  // namespace rime
@@ -10,6 +10,7 @@
 #include <rime/common.h>
 #include <rime/context.h>
 #include <rime/engine.h>
+#include <rime/algo/strings.h>
 #include <rime/dict/vocabulary.h>
 #include <rime/gear/charset_filter.h>
 
@@ -36,11 +37,14 @@ bool is_extended_cjk(uint32_t ch) {
   return false;
 }
 
-bool contains_extended_cjk(const string& text) {
-  const char* p = text.c_str();
+bool contains_extended_cjk(std::string_view text) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  if (strings::is_ascii(p, end))
+    return false;
   uint32_t ch;
 
-  while ((ch = utf8::unchecked::next(p)) != 0) {
+  while (p < end && (ch = utf8::unchecked::next(p)) != 0) {
     if (is_extended_cjk(ch)) {
       return true;
     }
@@ -95,6 +99,10 @@ bool CharsetFilter::FilterDictEntry(an<DictEntry> entry) {
   return entry && FilterText(entry->text);
 }
 
+bool CharsetFilter::FilterDictEntryView(const DictEntryView& entry) {
+  return !contains_extended_cjk(entry.text);
+}
+
 CharsetFilter::CharsetFilter(const Ticket& ticket)
     : Filter(ticket), TagMatching(ticket) {}
 
@@ -30,6 +30,7 @@ class CharsetFilterTranslation : public Translation {
 };
 
 struct DictEntry;
+struct DictEntryView;
 
 class CharsetFilter : public Filter, TagMatching {
  public:
@@ -43,6 +44,7 @@ class CharsetFilter : public Filter, TagMatching {
   // return true to accept, false to reject the tested item
   static bool FilterText(const string& text);
   static bool FilterDictEntry(an<DictEntry> entry);
+  static bool FilterDictEntryView(const DictEntryView& entry);
 };
 
 }  // namespace rime
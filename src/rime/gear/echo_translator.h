@@ -16,6 +16,7 @@ class EchoTranslator : public Translator {
   EchoTranslator(const Ticket& ticket);
 
   virtual an<Translation> Query(const string& input, const Segment& segment);
+  bool cacheable() const override { return true; }
 };
 
 }  // namespace rime
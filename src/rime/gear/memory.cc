@@ -4,6 +4,7 @@
 //
 // 2013-01-02 GONG Chen <chen.sst@gmail.com>
 //
+#include <chrono>
 #include <rime/candidate.h>
 #include <rime/context.h>
 #include <rime/composition.h>
@@ -12,6 +13,7 @@
 #include <rime/language.h>
 #include <rime/schema.h>
 #include <rime/ticket.h>
+#include <rime/translation_cache.h>
 #include <rime/dict/dictionary.h>
 #include <rime/dict/user_dictionary.h>
 #include <rime/gear/memory.h>
@@ -61,17 +63,36 @@ Memory::Memory(const Ticket& ticket) {
 
   if (auto dictionary = Dictionary::Require("dictionary")) {
     dict_.reset(dictionary->Create(ticket));
-    if (dict_)
-      dict_->Load();
   }
 
   if (auto user_dictionary = UserDictionary::Require("user_dictionary")) {
     user_dict_.reset(user_dictionary->Create(ticket));
-    if (user_dict_) {
-      user_dict_->Load();
-      if (dict_)
-        user_dict_->Attach(dict_->primary_table(), dict_->prism());
-    }
+  }
+
+  bool async_load = false;
+  if (ticket.schema) {
+    ticket.schema->config()->GetBool(ticket.name_space + "/async_load",
+                                     &async_load);
+  }
+#ifndef RIME_NO_THREADING
+  if (async_load && (dict_ || user_dict_)) {
+    // the dictionaries are not touched on the engine's thread until ready()
+    Engine* engine = ticket.engine;
+    string name = dict_ ? dict_->name() : user_dict_->name();
+    loading_ = std::async(std::launch::async, [this, engine, name] {
+      bool success = Load();
+      // delivered on the engine's thread. menus translated while loading
+      // are not reused.
+      engine->Post([engine, name, success] {
+        engine->translation_cache()->Clear();
+        engine->message_sink()("load",
+                               name + (success ? "/success" : "/failure"));
+      });
+    });
+  }
+#endif
+  if (!loading_.valid()) {
+    Load();
   }
 
   // user dictionary is named after language; dictionary name may have an
@@ -91,11 +112,43 @@ Memory::Memory(const Ticket& ticket) {
 }
 
 Memory::~Memory() {
+  if (loading_.valid()) {
+    loading_.wait();
+  }
   commit_connection_.disconnect();
   delete_connection_.disconnect();
   unhandled_key_connection_.disconnect();
 }
 
+bool Memory::Load() {
+  bool success = true;
+  if (dict_ && !dict_->Load()) {
+    success = false;
+  }
+  if (user_dict_) {
+    if (!user_dict_->Load()) {
+      success = false;
+    }
+    if (dict_)
+      user_dict_->Attach(dict_->primary_table(), dict_->prism());
+  }
+  return success;
+}
+
+bool Memory::ready() {
+  if (loading_.valid()) {
+    if (loading_.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+      return false;
+    loading_.get();
+  }
+  return true;
+}
+
+uint64_t Memory::generation() const {
+  return user_dict_ ? user_dict_->generation() : 0;
+}
+
 bool Memory::StartSession() {
   return user_dict_ && user_dict_->NewTransaction();
 }
@@ -126,7 +179,7 @@ bool Memory::ProcessSegmentOnCommit(CommitEntry& commit_entry,
 }
 
 void Memory::OnCommit(Context* ctx) {
-  if (!user_dict_ || user_dict_->readonly())
+  if (!ready() || !user_dict_ || user_dict_->readonly())
     return;
   StartSession();
   CommitEntry commit_entry(this);
@@ -136,7 +189,8 @@ void Memory::OnCommit(Context* ctx) {
 }
 
 void Memory::OnDeleteEntry(Context* ctx) {
-  if (!user_dict_ || user_dict_->readonly() || !ctx || !ctx->HasMenu())
+  if (!ready() || !user_dict_ || user_dict_->readonly() || !ctx ||
+      !ctx->HasMenu())
     return;
   auto phrase =
       As<Phrase>(Candidate::GetGenuineCandidate(ctx->GetSelectedCandidate()));
@@ -149,7 +203,7 @@ void Memory::OnDeleteEntry(Context* ctx) {
 }
 
 void Memory::OnUnhandledKey(Context* ctx, const KeyEvent& key) {
-  if (!user_dict_ || user_dict_->readonly())
+  if (!ready() || !user_dict_ || user_dict_->readonly())
     return;
   if ((key.modifier() & ~kShiftMask) == 0) {
     if (key.keycode() == XK_BackSpace && DiscardSession()) {
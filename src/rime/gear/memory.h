@@ -7,6 +7,7 @@
 #ifndef RIME_MEMORY_H_
 #define RIME_MEMORY_H_
 
+#include <future>
 #include <rime/common.h>
 #include <rime/dict/vocabulary.h>
 
@@ -44,9 +45,14 @@ class Memory {
   bool StartSession();
   bool FinishSession();
   bool DiscardSession();
+  // dictionaries can be used from now on. with async_load, they are being
+  // loaded on a background thread until then.
+  bool ready();
 
   Dictionary* dict() const { return dict_.get(); }
   UserDictionary* user_dict() const { return user_dict_.get(); }
+  // changes with every update of the user dictionary, by any session.
+  uint64_t generation() const;
 
   const Language* language() const { return language_.get(); }
 
@@ -54,12 +60,14 @@ class Memory {
   void OnCommit(Context* ctx);
   void OnDeleteEntry(Context* ctx);
   void OnUnhandledKey(Context* ctx, const KeyEvent& key);
+  bool Load();
 
   the<Dictionary> dict_;
   the<UserDictionary> user_dict_;
   the<Language> language_;
 
  private:
+  std::future<void> loading_;
   connection commit_connection_;
   connection delete_connection_;
   connection unhandled_key_connection_;
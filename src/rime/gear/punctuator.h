@@ -70,6 +70,7 @@ class PunctTranslator : public Translator {
  public:
   PunctTranslator(const Ticket& ticket);
   virtual an<Translation> Query(const string& input, const Segment& segment);
+  bool cacheable() const override { return true; }
 
  protected:
   an<Translation> TranslateUniquePunct(const string& key,
@@ -22,6 +22,7 @@ class ReverseLookupTranslator : public Translator {
   ReverseLookupTranslator(const Ticket& ticket);
 
   virtual an<Translation> Query(const string& input, const Segment& segment);
+  bool cacheable() const override { return true; }
 
  protected:
   void Initialize();
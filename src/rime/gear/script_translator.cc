@@ -89,6 +89,7 @@ class ScriptSyllabifier : public PhraseSyllabifier {
     if (corrector) {
       syllabifier_.EnableCorrection(corrector);
     }
+    syllabifier_.EnableCache(translator->syllable_graph_cache());
   }
 
   virtual Spans Syllabify(const Phrase* phrase);
@@ -97,14 +98,15 @@ class ScriptSyllabifier : public PhraseSyllabifier {
   string GetOriginalSpelling(const Phrase& cand) const;
   bool IsCorrection(const Code& code, size_t code_length) const;
 
-  const SyllableGraph& syllable_graph() const { return syllable_graph_; }
+  const SyllableGraph& syllable_graph() const { return *syllable_graph_; }
 
  protected:
   ScriptTranslator* translator_;
   string input_;
   size_t start_;
   Syllabifier syllabifier_;
-  SyllableGraph syllable_graph_;
+  // shared with the translator's cache, which never modifies it
+  an<const SyllableGraph> syllable_graph_ = New<SyllableGraph>();
 };
 
 class ScriptTranslation : public Translation {
@@ -195,7 +197,7 @@ ScriptTranslator::ScriptTranslator(const Ticket& ticket)
 
 an<Translation> ScriptTranslator::Query(const string& input,
                                         const Segment& segment) {
-  if (!dict_ || !dict_->loaded())
+  if (!ready() || !dict_ || !dict_->loaded())
     return nullptr;
   if (!segment.HasAnyTagIn(tags_))
     return nullptr;
@@ -342,7 +344,7 @@ Spans ScriptSyllabifier::Syllabify(const Phrase* phrase) {
   vector<size_t> vertices;
   vertices.push_back(start_);
   SyllabifyTask task{
-      phrase->code(), syllable_graph_, phrase->end() - start_,
+      phrase->code(), syllable_graph(), phrase->end() - start_,
       [&](SyllabifyTask* task, size_t depth, size_t current_pos,
           size_t next_pos) { vertices.push_back(start_ + next_pos); },
       [&](SyllabifyTask* task, size_t depth) { vertices.pop_back(); }};
@@ -353,8 +355,8 @@ Spans ScriptSyllabifier::Syllabify(const Phrase* phrase) {
 }
 
 size_t ScriptSyllabifier::BuildSyllableGraph(Prism& prism) {
-  return (size_t)syllabifier_.BuildSyllableGraph(input_, prism,
-                                                 &syllable_graph_);
+  syllable_graph_ = syllabifier_.BuildSyllableGraph(input_, prism);
+  return syllable_graph_->interpreted_length;
 }
 
 bool ScriptSyllabifier::IsCorrection(const Code& code,
@@ -362,15 +364,16 @@ bool ScriptSyllabifier::IsCorrection(const Code& code,
   vector<bool> path_attributes;
   path_attributes.reserve(8);
 
+  const auto& syllable_graph = this->syllable_graph();
   SyllabifyTask task{
-      code, syllable_graph_, code_length,
+      code, syllable_graph, code_length,
       // push
       [&](SyllabifyTask* task, size_t depth, size_t current_pos,
           size_t next_pos) {
         auto id = task->code[depth];
 
-        auto start_iter = syllable_graph_.edges.find(current_pos);
-        if (start_iter != syllable_graph_.edges.end()) {
+        auto start_iter = syllable_graph.edges.find(current_pos);
+        if (start_iter != syllable_graph.edges.end()) {
           auto end_iter = start_iter->second.find(next_pos);
           if (end_iter != start_iter->second.end()) {
             auto prop_iter = end_iter->second.find(id);
@@ -399,7 +402,8 @@ string ScriptSyllabifier::GetPreeditString(const Phrase& cand) const {
   const auto& delimiters = translator_->delimiters();
   std::stack<size_t> lengths;
   string output;
-  SyllabifyTask task{cand.matching_code(), syllable_graph_, cand.end() - start_,
+  SyllabifyTask task{cand.matching_code(), syllable_graph(),
+                     cand.end() - start_,
                      [&](SyllabifyTask* task, size_t depth, size_t current_pos,
                          size_t next_pos) {
                        size_t len = output.length();
@@ -673,6 +677,7 @@ an<Sentence> ScriptTranslation::MakeSentence(Dictionary* dict,
                                              UserDictionary* user_dict) {
   const int kMaxSyllablesForUserPhraseQuery = 5;
   const auto& syllable_graph = syllabifier_->syllable_graph();
+  auto lookups = dict->LookupGraph(syllable_graph, &translator_->blacklist());
   WordGraph graph;
   for (const auto& x : syllable_graph.edges) {
     auto& same_start_pos = graph[x.first];
@@ -682,8 +687,10 @@ an<Sentence> ScriptTranslation::MakeSentence(Dictionary* dict,
                                       kMaxSyllablesForUserPhraseQuery));
     }
     // merge lookup results
-    EnrollEntries(same_start_pos, dict->Lookup(syllable_graph, x.first,
-                                               &translator_->blacklist()));
+    auto found = lookups.find(x.first);
+    if (found != lookups.end()) {
+      EnrollEntries(same_start_pos, found->second);
+    }
   }
   if (auto sentence =
           poet_->MakeSentence(graph, syllable_graph.interpreted_length,
@@ -11,6 +11,7 @@
 #include <rime/translation.h>
 #include <rime/translator.h>
 #include <rime/algo/algebra.h>
+#include <rime/algo/syllabifier.h>
 #include <rime/gear/memory.h>
 #include <rime/gear/translator_commons.h>
 
@@ -22,7 +23,6 @@ struct DictEntry;
 class Dictionary;
 class Poet;
 class UserDictionary;
-struct SyllableGraph;
 
 class ScriptTranslator : public Translator,
                          public Memory,
@@ -35,6 +35,8 @@ class ScriptTranslator : public Translator,
   virtual bool Memorize(const CommitEntry& commit_entry) override;
   virtual bool ProcessSegmentOnCommit(CommitEntry& commit_entry,
                                       const Segment& seg) override;
+  bool cacheable() const override { return true; }
+  uint64_t generation() const override { return Memory::generation(); }
 
   string FormatPreedit(const string& preedit);
   string Spell(const Code& code);
@@ -53,6 +55,8 @@ class ScriptTranslator : public Translator,
   int max_word_length() const { return max_word_length_; }
   int core_word_length() const;
 
+  SyllableGraphCache* syllable_graph_cache() { return &syllable_graph_cache_; }
+
  protected:
   int max_homophones_ = 1;
   int spelling_hints_ = 0;
@@ -64,6 +68,7 @@ class ScriptTranslator : public Translator,
   the<Corrector> corrector_;
   the<Poet> poet_;
   vector<an<Phrase>> queue_;
+  SyllableGraphCache syllable_graph_cache_;
 };
 
 }  // namespace rime
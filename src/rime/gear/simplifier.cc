@@ -6,7 +6,6 @@
 //
 #include <boost/algorithm/string.hpp>
 #include <stdint.h>
-#include <utf8.h>
 #include <utility>
 #include <rime/candidate.h>
 #include <rime/common.h>
@@ -16,6 +15,7 @@
 #include <rime/schema.h>
 #include <rime/service.h>
 #include <rime/translation.h>
+#include <rime/algo/strings.h>
 #include <rime/gear/simplifier.h>
 #include <opencc/Config.hpp>  // Place OpenCC #includes here to avoid VS2015 compilation errors
 #include <opencc/Converter.hpp>
@@ -236,9 +236,7 @@ void Simplifier::PushBack(const an<Candidate>& original,
                           const string& simplified) {
   string tips;
   string text;
-  size_t length = utf8::unchecked::distance(
-      original->text().c_str(),
-      original->text().c_str() + original->text().length());
+  size_t length = strings::utf8_length(original->text());
   bool show_tips =
       (tips_level_ == kTipsChar && length == 1) || tips_level_ == kTipsAll;
   if (show_in_comment_) {
@@ -310,32 +308,33 @@ Simplifier* SimplifierComponent::Create(const Ticket& ticket) {
   if (opencc_config.empty()) {
     opencc_config = "t2s.json";  // default opencc config file
   }
-  opencc = opencc_map_[opencc_config].lock();
-  if (opencc) {
-    return new Simplifier(ticket, opencc);
-  }
-  path opencc_config_path = path(opencc_config);
-  if (opencc_config_path.extension().u8string() == ".ini") {
-    LOG(ERROR) << "please upgrade opencc_config to an opencc 1.0 config file.";
-    return nullptr;
-  }
-  if (opencc_config_path.is_relative()) {
-    path user_config_path = Service::instance().deployer().user_data_dir;
-    path shared_config_path = Service::instance().deployer().shared_data_dir;
-    (user_config_path /= "opencc") /= opencc_config_path;
-    (shared_config_path /= "opencc") /= opencc_config_path;
-    if (exists(user_config_path)) {
-      opencc_config_path = user_config_path;
-    } else if (exists(shared_config_path)) {
-      opencc_config_path = shared_config_path;
+  // 以原始配置中的文件路径作为 key，避免重复查找文件
+  opencc = opencc_cache_.Get(opencc_config, [&]() -> an<Opencc> {
+    path opencc_config_path = path(opencc_config);
+    if (opencc_config_path.extension().u8string() == ".ini") {
+      LOG(ERROR)
+          << "please upgrade opencc_config to an opencc 1.0 config file.";
+      return nullptr;
     }
-  }
-  try {
-    opencc = New<Opencc>(opencc_config_path);
-    // 以原始配置中的文件路径作为 key，避免重复查找文件
-    opencc_map_[opencc_config] = opencc;
-  } catch (opencc::Exception& e) {
-    LOG(ERROR) << "Error initializing opencc: " << e.what();
+    if (opencc_config_path.is_relative()) {
+      path user_config_path = Service::instance().deployer().user_data_dir;
+      path shared_config_path = Service::instance().deployer().shared_data_dir;
+      (user_config_path /= "opencc") /= opencc_config_path;
+      (shared_config_path /= "opencc") /= opencc_config_path;
+      if (exists(user_config_path)) {
+        opencc_config_path = user_config_path;
+      } else if (exists(shared_config_path)) {
+        opencc_config_path = shared_config_path;
+      }
+    }
+    try {
+      return New<Opencc>(opencc_config_path);
+    } catch (opencc::Exception& e) {
+      LOG(ERROR) << "Error initializing opencc: " << e.what();
+      return nullptr;
+    }
+  });
+  if (!opencc) {
     return nullptr;
   }
   return new Simplifier(ticket, opencc);
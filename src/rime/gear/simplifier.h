@@ -8,6 +8,7 @@
 #define RIME_SIMPLIFIER_H_
 
 #include <rime/filter.h>
+#include <rime/resource_cache.h>
 #include <rime/algo/algebra.h>
 #include <rime/gear/filter_commons.h>
 
@@ -49,8 +50,10 @@ class SimplifierComponent : public Simplifier::Component {
   SimplifierComponent();
   Simplifier* Create(const Ticket& ticket);
 
+  ResourceCacheStats opencc_cache_stats() { return opencc_cache_.stats(); }
+
  private:
-  hash_map<string, weak<Opencc>> opencc_map_;
+  ResourceCache<Opencc> opencc_cache_;
 };
 
 }  // namespace rime
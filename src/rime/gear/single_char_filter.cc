@@ -4,16 +4,16 @@
 //
 // 2014-11-19 Chen Gong <chen.sst@gmail.com>
 //
-#include <utf8.h>
 #include <rime/candidate.h>
 #include <rime/translation.h>
+#include <rime/algo/strings.h>
 #include <rime/gear/single_char_filter.h>
 #include <rime/gear/translator_commons.h>
 
 namespace rime {
 
 static inline size_t unistrlen(const string& text) {
-  return utf8::unchecked::distance(text.c_str(), text.c_str() + text.length());
+  return strings::utf8_length(text);
 }
 
 class SingleCharFirstTranslation : public PrefetchTranslation {
@@ -7,7 +7,6 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <cmath>
-#include <utf8.h>
 #include <rime/candidate.h>
 #include <rime/common.h>
 #include <rime/composition.h>
@@ -16,6 +15,7 @@
 #include <rime/engine.h>
 #include <rime/schema.h>
 #include <rime/translation.h>
+#include <rime/algo/strings.h>
 #include <rime/dict/dictionary.h>
 #include <rime/dict/user_dictionary.h>
 #include <rime/gear/charset_filter.h>
@@ -243,7 +243,7 @@ static bool starts_with_completion(an<Translation> translation) {
 
 an<Translation> TableTranslator::Query(const string& input,
                                        const Segment& segment) {
-  if (!segment.HasAnyTagIn(tags_))
+  if (!ready() || !segment.HasAnyTagIn(tags_))
     return nullptr;
   DLOG(INFO) << "input = '" << input << "', [" << segment.start << ", "
              << segment.end << ")";
@@ -342,8 +342,7 @@ bool TableTranslator::Memorize(const CommitEntry& commit_entry) {
             continue;
           }
           phrase = it->text + phrase;  // prepend another word
-          size_t phrase_length = utf8::unchecked::distance(
-              phrase.c_str(), phrase.c_str() + phrase.length());
+          size_t phrase_length = strings::utf8_length(phrase);
           if (static_cast<int>(phrase_length) > max_phrase_length_)
             break;
           DLOG(INFO) << "phrase: " << phrase;
@@ -571,7 +570,7 @@ an<Translation> TableTranslator::MakeSentence(const string& input,
         string key = active_input.substr(0, len);
         user_dict_->LookupWords(&uter, key, false, 0, &resume_key);
         if (filter_by_charset) {
-          uter.AddFilter(CharsetFilter::FilterDictEntry);
+          uter.AddFilter(CharsetFilter::FilterDictEntryView);
         }
         if (!uter.exhausted()) {
           vertices.insert(end_pos);
@@ -609,7 +608,7 @@ an<Translation> TableTranslator::MakeSentence(const string& input,
         string key = active_input.substr(0, len);
         encoder_->LookupPhrases(&uter, key, false, 0, &resume_key);
         if (filter_by_charset) {
-          uter.AddFilter(CharsetFilter::FilterDictEntry);
+          uter.AddFilter(CharsetFilter::FilterDictEntryView);
         }
         if (!uter.exhausted()) {
           vertices.insert(end_pos);
@@ -650,7 +649,7 @@ an<Translation> TableTranslator::MakeSentence(const string& input,
         dict_->LookupWords(&iter, active_input.substr(0, m.length), false, 0,
                            &blacklist());
         if (filter_by_charset) {
-          iter.AddFilter(CharsetFilter::FilterDictEntry);
+          iter.AddFilter(CharsetFilter::FilterDictEntryView);
         }
         if (!iter.exhausted()) {
           vertices.insert(end_pos);
@@ -30,6 +30,8 @@ class TableTranslator : public Translator,
 
   virtual an<Translation> Query(const string& input, const Segment& segment);
   virtual bool Memorize(const CommitEntry& commit_entry);
+  bool cacheable() const override { return true; }
+  uint64_t generation() const override { return Memory::generation(); }
 
   an<Translation> MakeSentence(const string& input,
                                size_t start,
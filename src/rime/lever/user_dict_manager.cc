@@ -48,7 +48,13 @@ void UserDictManager::GetUserDictList(UserDictList* user_dict_list,
   }
 }
 
+std::mutex& UserDictManager::db_mutex(const string& db_name) {
+  std::lock_guard<std::mutex> lock(db_mutexes_mutex_);
+  return db_mutexes_[db_name];
+}
+
 bool UserDictManager::Backup(const string& dict_name) {
+  std::lock_guard<std::mutex> lock(db_mutex(dict_name));
   the<Db> db(user_db_component_->Create(dict_name));
   if (!db->OpenReadOnly())
     return false;
@@ -71,6 +77,7 @@ bool UserDictManager::Backup(const string& dict_name) {
 }
 
 bool UserDictManager::Restore(const path& snapshot_file) {
+  std::lock_guard<std::mutex> lock(restore_mutex_);
   the<Db> temp(user_db_component_->Create(".temp"));
   if (temp->Exists())
     temp->Remove();
@@ -88,6 +95,7 @@ bool UserDictManager::Restore(const path& snapshot_file) {
   string db_name = UserDbHelper(temp).GetDbName();
   if (db_name.empty())
     return false;
+  std::lock_guard<std::mutex> dest_lock(db_mutex(db_name));
   the<Db> dest(user_db_component_->Create(db_name));
   if (!dest->Open())
     return false;
@@ -175,6 +183,47 @@ bool UserDictManager::UpgradeUserDict(const string& dict_name) {
          legacy_db->Remove() && Restore(snapshot_path);
 }
 
+bool UserDictManager::MergeSnapshots(const string& dict_name,
+                                     const vector<path>& snapshot_files) {
+  if (snapshot_files.empty())
+    return true;
+  bool success = true;
+  vector<path> other_snapshots;
+  {
+    std::lock_guard<std::mutex> lock(db_mutex(dict_name));
+    the<Db> db(user_db_component_->Create(dict_name));
+    if (!db->Open())
+      return false;
+    BOOST_SCOPE_EXIT((&db)) {
+      db->Close();
+    }
+    BOOST_SCOPE_EXIT_END
+    UserDbSnapshotMerger merger(db.get());
+    for (const path& file_path : snapshot_files) {
+      LOG(INFO) << "merging snapshot file: " << file_path;
+      if (!merger.AddSnapshot(file_path))
+        other_snapshots.push_back(file_path);
+    }
+    auto report_progress = [&dict_name](int merged, int total) {
+      LOG(INFO) << "merged " << merged << "/" << total
+                << " entries into user dict '" << dict_name << "'.";
+    };
+    if (merger.num_snapshots() > 0 && merger.Merge(report_progress) < 0) {
+      LOG(ERROR) << "failed to merge snapshots into user dict '" << dict_name
+                 << "'.";
+      success = false;
+    }
+  }
+  // those not fit for merging in one pass are restored one by one.
+  for (const path& file_path : other_snapshots) {
+    if (!Restore(file_path)) {
+      LOG(ERROR) << "failed to merge snapshot file: " << file_path;
+      success = false;
+    }
+  }
+  return success;
+}
+
 bool UserDictManager::Synchronize(const string& dict_name) {
   LOG(INFO) << "synchronize user dict '" << dict_name << "'.";
   bool success = true;
@@ -188,18 +237,18 @@ bool UserDictManager::Synchronize(const string& dict_name) {
   }
   // *.userdb.txt
   string snapshot_file = dict_name + UserDb::snapshot_extension();
+  vector<path> snapshot_files;
   for (fs::directory_iterator it(sync_dir), end; it != end; ++it) {
     if (!fs::is_directory(it->path()))
       continue;
     path file_path = path(it->path()) / snapshot_file;
     if (fs::exists(file_path)) {
-      LOG(INFO) << "merging snapshot file: " << file_path;
-      if (!Restore(file_path)) {
-        LOG(ERROR) << "failed to merge snapshot file: " << file_path;
-        success = false;
-      }
+      snapshot_files.push_back(file_path);
     }
   }
+  if (!MergeSnapshots(dict_name, snapshot_files)) {
+    success = false;
+  }
   if (!Backup(dict_name)) {
     LOG(ERROR) << "error backing up user dict '" << dict_name << "'.";
     success = false;
@@ -207,14 +256,31 @@ bool UserDictManager::Synchronize(const string& dict_name) {
   return success;
 }
 
-bool UserDictManager::SynchronizeAll() {
+bool UserDictManager::SynchronizeAll(bool parallel) {
   UserDictList user_dicts;
   GetUserDictList(&user_dicts);
   LOG(INFO) << "synchronizing " << user_dicts.size() << " user dicts.";
+  if (parallel && user_dicts.size() > 1) {
+    // create the directories before user dicts race to do so.
+    std::error_code ec;
+    fs::create_directories(deployer_->user_data_sync_dir(), ec);
+  }
   int failure = 0;
-  for (const string& dict_name : user_dicts) {
-    if (!Synchronize(dict_name))
-      ++failure;
+  if (parallel) {
+    vector<std::future<bool>> results;
+    for (const string& dict_name : user_dicts) {
+      results.push_back(
+          RunAsync([this, &dict_name] { return Synchronize(dict_name); }));
+    }
+    for (auto& result : results) {
+      if (!result.get())
+        ++failure;
+    }
+  } else {
+    for (const string& dict_name : user_dicts) {
+      if (!Synchronize(dict_name))
+        ++failure;
+    }
   }
   if (failure) {
     LOG(ERROR) << "failed synchronizing " << failure << "/" << user_dicts.size()
@@ -7,6 +7,7 @@
 #ifndef RIME_USER_DICT_MANAGER_H_
 #define RIME_USER_DICT_MANAGER_H_
 
+#include <mutex>
 #include <rime/common.h>
 #include <rime/dict/user_db.h>
 
@@ -34,12 +35,25 @@ class RIME_DLL UserDictManager {
   int Import(const string& dict_name, const path& text_file);
 
   bool Synchronize(const string& dict_name);
-  bool SynchronizeAll();
+  // if parallel is true, user dicts are synchronized at the same time,
+  // taking turns to write to any user db they share.
+  bool SynchronizeAll(bool parallel = true);
 
  protected:
+  // merges snapshots of a user dict from all devices in one pass.
+  bool MergeSnapshots(const string& dict_name,
+                      const vector<path>& snapshot_files);
+  // held while writing to a user db, which user dicts synchronized in
+  // parallel may share by restoring snapshots; never nested.
+  std::mutex& db_mutex(const string& db_name);
+
   Deployer* deployer_;
   path path_;
   UserDb::Component* user_db_component_;
+  // restoring goes through a temporary db shared by all user dicts
+  std::mutex restore_mutex_;
+  std::mutex db_mutexes_mutex_;
+  map<string, std::mutex> db_mutexes_;
 };
 
 }  // namespace rime
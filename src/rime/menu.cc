@@ -23,8 +23,13 @@ void Menu::AddFilter(Filter* filter) {
   result_ = filter->Apply(result_, &candidates_);
 }
 
+void Menu::Defer(Populator populate) {
+  populate_ = std::move(populate);
+}
+
 size_t Menu::Prepare(size_t requested) {
   DLOG(INFO) << "preparing " << requested << " candidates.";
+  Populate();
   while (candidates_.size() < requested && !result_->exhausted()) {
     if (auto cand = result_->Peek()) {
       candidates_.push_back(cand);
@@ -35,6 +40,7 @@ size_t Menu::Prepare(size_t requested) {
 }
 
 Page* Menu::CreatePage(size_t page_size, size_t page_no) {
+  Populate();
   size_t start_pos = page_size * page_no;
   size_t end_pos = start_pos + page_size;
   if (end_pos > candidates_.size()) {
@@ -65,6 +71,7 @@ an<Candidate> Menu::GetCandidateAt(size_t index) {
 }
 
 bool Menu::empty() const {
+  Populate();
   return candidates_.empty() && result_->exhausted();
 }
 
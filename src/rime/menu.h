@@ -26,10 +26,15 @@ class Translation;
 
 class Menu {
  public:
+  using Populator = function<void(Menu* menu)>;
+
   RIME_DLL Menu();
 
   RIME_DLL void AddTranslation(an<Translation> translation);
   void AddFilter(Filter* filter);
+  // translations and filters are added by populate() when candidates are
+  // first requested.
+  RIME_DLL void Defer(Populator populate);
 
   RIME_DLL size_t Prepare(size_t candidate_count);
   RIME_DLL Page* CreatePage(size_t page_size, size_t page_no);
@@ -42,6 +47,17 @@ class Menu {
   bool empty() const;
 
  private:
+  // deferred population does not change what the menu has to offer, so it
+  // is done on demand even if the menu is accessed as const.
+  void Populate() const {
+    if (populate_) {
+      auto populate = std::move(populate_);
+      populate_ = nullptr;
+      populate(const_cast<Menu*>(this));
+    }
+  }
+
+  mutable Populator populate_;
   an<MergedTranslation> merged_;
   an<Translation> result_;
   CandidateList candidates_;
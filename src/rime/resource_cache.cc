@@ -0,0 +1,62 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <mutex>
+#include <rime/config.h>
+#include <rime/resource_cache.h>
+
+namespace rime {
+
+ResourceRetention LoadResourceRetention() {
+  ResourceRetention retention;
+  auto component = Config::Require("config");
+  if (!component)
+    return retention;
+  the<Config> config(component->Create("default"));
+  if (!config)
+    return retention;
+  int memory_budget = 0;
+  if (config->GetInt("resource_retention/memory_budget", &memory_budget) &&
+      memory_budget > 0) {
+    retention.memory_budget = size_t(memory_budget) << 20;
+  }
+  config->GetInt("resource_retention/idle_timeout", &retention.idle_timeout);
+  return retention;
+}
+
+static std::mutex& registry_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+static set<ResourceCacheBase*>& registry() {
+  static set<ResourceCacheBase*> caches;
+  return caches;
+}
+
+void ResourceCacheBase::Register() {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  registry().insert(this);
+}
+
+void ResourceCacheBase::Unregister() {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  registry().erase(this);
+}
+
+void ResourceCacheBase::TrimAll() {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  for (auto* cache : registry()) {
+    cache->Trim();
+  }
+}
+
+void ResourceCacheBase::ReleaseAllRetained() {
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  for (auto* cache : registry()) {
+    cache->ReleaseRetained();
+  }
+}
+
+}  // namespace rime
@@ -0,0 +1,222 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#ifndef RIME_RESOURCE_CACHE_H_
+#define RIME_RESOURCE_CACHE_H_
+
+#include <ctime>
+#include <mutex>
+#include <rime_api.h>
+#include <rime/common.h>
+
+namespace rime {
+
+// how long shared resources are kept after their last user is gone.
+struct ResourceRetention {
+  // total size in bytes of the retained resources; 0 disables retention.
+  size_t memory_budget = 0;
+  // seconds to retain a resource since it was last acquired; 0 for no limit.
+  int idle_timeout = 0;
+};
+
+// reads resource_retention/memory_budget (in megabytes) and
+// resource_retention/idle_timeout (in seconds) from default.yaml.
+RIME_DLL ResourceRetention LoadResourceRetention();
+
+// sizes a file-backed resource, such as a MappedFile, by its file on disk.
+template <class T>
+size_t SizeOfFile(const T& resource) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(resource.file_path(), ec);
+  return ec ? 0 : size_t(size);
+}
+
+struct ResourceCacheStats {
+  // found alive when acquired
+  size_t hits = 0;
+  // of the hits, those kept alive only by retention
+  size_t revivals = 0;
+  // created for the first time
+  size_t loads = 0;
+  // created again after having been released
+  size_t reloads = 0;
+  size_t evictions = 0;
+};
+
+// resource caches of all components, for maintenance of the retained
+// resources across them.
+class RIME_DLL ResourceCacheBase {
+ public:
+  virtual ~ResourceCacheBase() = default;
+  // evicts retained resources beyond the retention limits.
+  virtual void Trim() = 0;
+  // evicts all retained resources; those in use stay alive.
+  virtual void ReleaseRetained() = 0;
+
+  // trims every resource cache, as resources also expire while idle.
+  static void TrimAll();
+  // releases retained resources of every cache, e.g. before the files they
+  // are loaded from are rebuilt.
+  static void ReleaseAllRetained();
+
+ protected:
+  // called by the fully constructed caches.
+  void Register();
+  void Unregister();
+};
+
+// shares resources such as mapped dictionary files by name. a resource is
+// released when its last user is gone, unless retained: the most recently
+// acquired ones are kept within the memory budget and idle timeout.
+// retention is read from default.yaml on first use, unless set explicitly.
+template <class T>
+class ResourceCache : public ResourceCacheBase {
+ public:
+  using Creator = function<an<T>()>;
+  // estimates the memory a resource takes
+  using Sizer = function<size_t(const T&)>;
+
+  explicit ResourceCache(Sizer sizer = nullptr) : sizer_(std::move(sizer)) {
+    Register();
+  }
+  ~ResourceCache() override { Unregister(); }
+
+  // returns the resource of the given name, or create() one if none is alive.
+  an<T> Get(const string& name, const Creator& create);
+  void Trim() override;
+  void ReleaseRetained() override;
+
+  void set_retention(const ResourceRetention& retention);
+  ResourceCacheStats stats();
+
+ private:
+  struct Entry {
+    weak<T> resource;
+    an<T> retained;
+    time_t last_acquired = 0;
+    bool ever_created = false;
+    // position in lru_ while retained
+    list<string>::iterator lru;
+  };
+
+  void Retain(const string& name, Entry& entry, const an<T>& resource);
+  void TrimLocked();
+  void Evict(Entry& entry);
+
+  std::mutex mutex_;
+  map<string, Entry> entries_;
+  // names of the retained resources, most recently acquired first
+  list<string> lru_;
+  Sizer sizer_;
+  ResourceRetention retention_;
+  bool retention_set_ = false;
+  ResourceCacheStats stats_;
+};
+
+template <class T>
+an<T> ResourceCache<T>::Get(const string& name, const Creator& create) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!retention_set_) {
+    retention_ = LoadResourceRetention();
+    retention_set_ = true;
+  }
+  auto& entry = entries_[name];
+  auto resource = entry.resource.lock();
+  if (resource) {
+    ++stats_.hits;
+    // held here and by the cache alone
+    if (entry.retained && resource.use_count() == 2) {
+      ++stats_.revivals;
+    }
+  } else {
+    resource = create();
+    if (!resource)
+      return nullptr;
+    entry.resource = resource;
+    ++(entry.ever_created ? stats_.reloads : stats_.loads);
+    entry.ever_created = true;
+  }
+  Retain(name, entry, resource);
+  TrimLocked();
+  return resource;
+}
+
+template <class T>
+void ResourceCache<T>::Retain(const string& name,
+                              Entry& entry,
+                              const an<T>& resource) {
+  if (retention_.memory_budget == 0)
+    return;
+  if (entry.retained) {
+    lru_.erase(entry.lru);
+  }
+  entry.retained = resource;
+  entry.last_acquired = time(NULL);
+  lru_.push_front(name);
+  entry.lru = lru_.begin();
+}
+
+template <class T>
+void ResourceCache<T>::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TrimLocked();
+}
+
+template <class T>
+void ResourceCache<T>::ReleaseRetained() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!lru_.empty()) {
+    Evict(entries_[lru_.front()]);
+  }
+}
+
+template <class T>
+void ResourceCache<T>::TrimLocked() {
+  time_t expired = retention_.idle_timeout > 0
+                       ? time(NULL) - retention_.idle_timeout
+                       : 0;
+  size_t total_size = 0;
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    auto& entry = entries_[*it++];
+    // once over budget, the less recently acquired ones are all evicted
+    if (total_size <= retention_.memory_budget) {
+      total_size += sizer_ ? sizer_(*entry.retained) : 0;
+    }
+    if (total_size > retention_.memory_budget ||
+        entry.last_acquired < expired) {
+      Evict(entry);
+    }
+  }
+}
+
+template <class T>
+void ResourceCache<T>::Evict(Entry& entry) {
+  lru_.erase(entry.lru);
+  entry.retained.reset();
+  ++stats_.evictions;
+}
+
+template <class T>
+void ResourceCache<T>::set_retention(const ResourceRetention& retention) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  retention_ = retention;
+  retention_set_ = true;
+  if (retention_.memory_budget == 0) {
+    while (!lru_.empty()) {
+      Evict(entries_[lru_.front()]);
+    }
+  } else {
+    TrimLocked();
+  }
+}
+
+template <class T>
+ResourceCacheStats ResourceCache<T>::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace rime
+
+#endif  // RIME_RESOURCE_CACHE_H_
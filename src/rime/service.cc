@@ -7,6 +7,7 @@
 #include <rime/context.h>
 #include <rime/engine.h>
 #include <rime/resource.h>
+#include <rime/resource_cache.h>
 #include <rime/schema.h>
 #include <rime/service.h>
 
@@ -27,6 +28,10 @@ bool Session::ProcessKey(const KeyEvent& key_event) {
   return engine_->ProcessKey(key_event);
 }
 
+bool Session::ProcessKeys(const KeySequence& keys) {
+  return engine_->ProcessKeys(keys);
+}
+
 void Session::Activate() {
   last_active_time_ = time(NULL);
 }
@@ -90,7 +95,9 @@ SessionId Service::CreateSession() {
     auto session = New<Session>();
     session->Activate();
     id = reinterpret_cast<uintptr_t>(session.get());
-    sessions_[id] = session;
+    auto& shard = shard_of(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.sessions[id] = session;
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Error creating session: " << ex.what();
   } catch (const string& ex) {
@@ -108,42 +115,67 @@ SessionId Service::CreateSession() {
 an<Session> Service::GetSession(SessionId session_id) {
   if (disabled())
     return nullptr;
-  SessionMap::iterator it = sessions_.find(session_id);
-  if (it != sessions_.end()) {
-    auto& session = it->second;
-    session->Activate();
-    return session;
+  an<Session> session;
+  {
+    auto& shard = shard_of(session_id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(session_id);
+    if (it == shard.sessions.end())
+      return nullptr;
+    session = it->second;
   }
-  return nullptr;
+  session->Activate();
+  return session;
 }
 
 bool Service::DestroySession(SessionId session_id) {
-  auto it = sessions_.find(session_id);
-  if (it == sessions_.end())
-    return false;
-  sessions_.erase(it);
+  // the session is disposed of after the lock is released.
+  an<Session> session;
+  {
+    auto& shard = shard_of(session_id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(session_id);
+    if (it == shard.sessions.end())
+      return false;
+    session.swap(it->second);
+    shard.sessions.erase(it);
+  }
   return true;
 }
 
 void Service::CleanupStaleSessions() {
   time_t now = time(NULL);
-  int count = 0;
-  for (auto it = sessions_.begin(); it != sessions_.end();) {
-    if (it->second &&
-        it->second->last_active_time() < now - Session::kLifeSpan) {
-      sessions_.erase(it++);
-      ++count;
-    } else {
-      ++it;
+  vector<an<Session>> stale_sessions;
+  for (auto& shard : shards_) {
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+      if (it->second &&
+          it->second->last_active_time() < now - Session::kLifeSpan) {
+        stale_sessions.push_back(std::move(it->second));
+        shard.sessions.erase(it++);
+      } else {
+        ++it;
+      }
     }
   }
-  if (count > 0) {
-    LOG(INFO) << "Recycled " << count << " stale sessions.";
+  // engines are destroyed without holding any lock.
+  if (!stale_sessions.empty()) {
+    LOG(INFO) << "Recycled " << stale_sessions.size() << " stale sessions.";
   }
+  stale_sessions.clear();
+  // resources also expire while no one is acquiring them
+  ResourceCacheBase::TrimAll();
 }
 
 void Service::CleanupAllSessions() {
-  sessions_.clear();
+  for (auto& shard : shards_) {
+    SessionMap sessions;
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      sessions.swap(shard.sessions);
+    }
+  }
+  ResourceCacheBase::ReleaseAllRetained();
 }
 
 void Service::SetNotificationHandler(const NotificationHandler& handler) {
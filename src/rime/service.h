@@ -9,7 +9,9 @@
 
 #include <stdint.h>
 #include <time.h>
+#include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <rime/common.h>
 #include <rime/deployer.h>
 
@@ -26,6 +28,7 @@ using NotificationHandler = function<void(SessionId session_id,
 class Context;
 class Engine;
 class KeyEvent;
+class KeySequence;
 class Schema;
 
 class Session {
@@ -34,6 +37,8 @@ class Session {
 
   Session();
   bool ProcessKey(const KeyEvent& key_event);
+  // processes keys in a batch, translating only what is needed.
+  bool ProcessKeys(const KeySequence& keys);
   void Activate();
   void ResetCommitText();
   bool CommitComposition();
@@ -49,7 +54,7 @@ class Session {
   void OnCommit(const string& commit_text);
 
   the<Engine> engine_;
-  time_t last_active_time_ = 0;
+  std::atomic<time_t> last_active_time_{0};
   string commit_text_;
 };
 
@@ -90,7 +95,20 @@ class RIME_DLL Service {
   Service();
 
   using SessionMap = map<SessionId, an<Session>>;
-  SessionMap sessions_;
+  // sessions are spread over shards, each guarded by its own lock, so that
+  // sessions used from different threads seldom wait for each other.
+  struct SessionShard {
+    std::shared_mutex mutex;
+    SessionMap sessions;
+  };
+  static const size_t kNumSessionShards = 16;
+
+  SessionShard& shard_of(SessionId session_id) {
+    // session ids are addresses of sessions
+    return shards_[(session_id >> 4) % kNumSessionShards];
+  }
+
+  SessionShard shards_[kNumSessionShards];
   Deployer deployer_;
   NotificationHandler notification_handler_;
   std::mutex mutex_;
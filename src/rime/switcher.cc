@@ -4,6 +4,7 @@
 //
 // 2011-12-07 GONG Chen <chen.sst@gmail.com>
 //
+#include <mutex>
 #include <rime/candidate.h>
 #include <rime/common.h>
 #include <rime/composition.h>
@@ -20,6 +21,9 @@
 
 namespace rime {
 
+// user config is shared by switchers in sessions on different threads.
+static std::mutex user_config_mutex;
+
 Switcher::Switcher(const Ticket& ticket) : Processor(ticket) {
   context_->set_option("dumb", true);  // not going to commit anything
 
@@ -39,6 +43,7 @@ Switcher::~Switcher() {
 
 void Switcher::RestoreSavedOptions() {
   if (user_config_) {
+    std::lock_guard<std::mutex> lock(user_config_mutex);
     for (const string& option_name : save_options_) {
       bool value = false;
       if (user_config_->GetBool("var/option/" + option_name, &value)) {
@@ -164,6 +169,7 @@ int Switcher::ForEachSchemaListEntry(
 
 void Switcher::SetActiveSchema(const string& schema_id) {
   if (user_config_) {
+    std::lock_guard<std::mutex> lock(user_config_mutex);
     user_config_->SetString("var/previously_selected_schema", schema_id);
     user_config_->SetInt("var/schema_access_time/" + schema_id, time(NULL));
     // persist recently used schema and options that have changed
@@ -177,6 +183,7 @@ Schema* Switcher::CreateSchema() {
     return nullptr;
   string previous;
   if (user_config_ && !fix_schema_list_order_) {
+    std::lock_guard<std::mutex> lock(user_config_mutex);
     user_config_->GetString("var/previously_selected_schema", &previous);
   }
   string recent;
@@ -0,0 +1,58 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <rime/menu.h>
+#include <rime/segmentation.h>
+#include <rime/translation_cache.h>
+
+namespace rime {
+
+bool TranslationCacheKey::operator==(const TranslationCacheKey& other) const {
+  return start == other.start && input == other.input && tags == other.tags &&
+         at_end == other.at_end && preceding_text == other.preceding_text &&
+         options == other.options && caret == other.caret &&
+         generation == other.generation;
+}
+
+an<Menu> TranslationCache::Find(const TranslationCacheKey& key,
+                                Segment* segment) {
+  auto found = std::find_if(entries_.begin(), entries_.end(),
+                            [&](const Entry& e) { return e.key == key; });
+  if (found == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, found);
+  segment->prompt = found->prompt;
+  return found->menu;
+}
+
+void TranslationCache::Insert(TranslationCacheKey key,
+                              const Segment& segment) {
+  if (capacity_ == 0 || !segment.menu)
+    return;
+  auto found = std::find_if(entries_.begin(), entries_.end(),
+                            [&](const Entry& e) { return e.key == key; });
+  if (found != entries_.end()) {
+    entries_.erase(found);
+  }
+  entries_.push_front({std::move(key), segment.menu, segment.prompt});
+  if (entries_.size() > capacity_) {
+    entries_.pop_back();
+  }
+}
+
+void TranslationCache::Clear() {
+  entries_.clear();
+}
+
+void TranslationCache::set_capacity(size_t capacity) {
+  capacity_ = capacity;
+  if (entries_.size() > capacity_) {
+    entries_.resize(capacity_);
+  }
+}
+
+}  // namespace rime
@@ -0,0 +1,73 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#ifndef RIME_TRANSLATION_CACHE_H_
+#define RIME_TRANSLATION_CACHE_H_
+
+#include <rime_api.h>
+#include <rime/common.h>
+
+namespace rime {
+
+class Menu;
+struct Segment;
+
+// what translators and filters see of a segment and its surroundings.
+struct TranslationCacheKey {
+  size_t start = 0;
+  string input;
+  set<string> tags;
+  // whether the segment reaches the end of input
+  bool at_end = false;
+  // text of the selected candidates before the segment
+  string preceding_text;
+  map<string, bool> options;
+  // caret position relative to the segment start, clamped to the segment
+  size_t caret = 0;
+  // sum of the generations of translators, bumped by user dictionary updates
+  uint64_t generation = 0;
+
+  bool operator==(const TranslationCacheKey& other) const;
+};
+
+// keeps menus of recently translated segments in an input session, so that
+// composing the same segment again, e.g. after moving the caret back and
+// forth or toggling an option twice, reuses the candidates obtained so far
+// and continues from where the translations left off.
+// only used when every translator of the engine is cacheable.
+class TranslationCache {
+ public:
+  static const size_t kDefaultCapacity = 16;
+
+  explicit TranslationCache(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity) {}
+
+  // on a hit, also restores the prompt set by translators.
+  RIME_DLL an<Menu> Find(const TranslationCacheKey& key, Segment* segment);
+  RIME_DLL void Insert(TranslationCacheKey key, const Segment& segment);
+  RIME_DLL void Clear();
+
+  size_t capacity() const { return capacity_; }
+  void set_capacity(size_t capacity);
+  size_t size() const { return entries_.size(); }
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    TranslationCacheKey key;
+    an<Menu> menu;
+    string prompt;
+  };
+
+  // most recently used first
+  list<Entry> entries_;
+  size_t capacity_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+}  // namespace rime
+
+#endif  // RIME_TRANSLATION_CACHE_H_
@@ -30,6 +30,13 @@ class Translator : public Class<Translator, const Ticket&> {
 
   string name_space() const { return name_space_; }
 
+  // whether menus can be reused for the same input and segment, as long as
+  // generation() stays the same. translators that depend on time or other
+  // changing state are not cached unless they say so.
+  virtual bool cacheable() const { return false; }
+  // changes whenever the data the translator looks up has changed.
+  virtual uint64_t generation() const { return 0; }
+
  protected:
   Engine* engine_;
   string name_space_;
@@ -223,6 +223,10 @@ typedef struct rime_string_slice_t {
  *   + session_id = 0, message_type="deploy", message_value="start"
  *   + session_id = 0, message_type="deploy", message_value="success"
  *   + session_id = 0, message_type="deploy", message_value="failure"
+ * - on loading dictionaries in the background (async_load),
+ *   when the session next processes input:
+ *   + message_type="load", message_value="luna_pinyin/success"
+ *   + message_type="load", message_value="luna_pinyin/failure"
  *
  *   handler will be called with context_object as the first parameter
  *   every time an event occurs in librime, until RimeFinalize() is called.
@@ -275,6 +279,10 @@ typedef struct RIME_FLAVORED(rime_api_t) {
    *    + session_id = 0, message_type="deploy", message_value="start"
    *    + session_id = 0, message_type="deploy", message_value="success"
    *    + session_id = 0, message_type="deploy", message_value="failure"
+   *  - on loading dictionaries in the background (async_load),
+   *    when the session next processes input:
+   *    + message_type="load", message_value="luna_pinyin/success"
+   *    + message_type="load", message_value="luna_pinyin/failure"
    *
    *  handler will be called with context_object as the first parameter
    *  every time an event occurs in librime, until RimeFinalize() is called.
@@ -303,6 +311,12 @@ typedef struct RIME_FLAVORED(rime_api_t) {
   Bool (*sync_user_data)(void);
 
   // session management
+  //
+  // sessions share user dictionaries, so calls into sessions must not
+  // overlap, even for distinct sessions; they may be made from different
+  // threads one at a time. dictionaries may still be loaded in the
+  // background (see async_load). deployment, user data sync and options
+  // saved to user config should not run concurrently with input.
 
   RimeSessionId (*create_session)(void);
   Bool (*find_session)(RimeSessionId session_id);
@@ -505,6 +519,15 @@ typedef struct RIME_FLAVORED(rime_api_t) {
                                               size_t index);
 
   Bool (*change_page)(RimeSessionId session_id, Bool backward);
+
+  //! process a batch of keys, eg. when replaying recorded input.
+  //! candidates are translated only for the state after the last key,
+  //! unless they are needed to process the keys. masks can be NULL.
+  //! return True if every key is accepted.
+  Bool (*process_keys)(RimeSessionId session_id,
+                       const int* keycodes,
+                       const int* masks,
+                       size_t count);
 } RIME_FLAVORED(RimeApi);
 
 //! API entry
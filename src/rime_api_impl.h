@@ -776,12 +776,27 @@ RIME_DEPRECATED Bool RimeSimulateKeySequence(RimeSessionId session_id,
     LOG(ERROR) << "error parsing input: '" << key_sequence << "'";
     return False;
   }
-  for (const KeyEvent& key : keys) {
-    session->ProcessKey(key);
-  }
+  session->ProcessKeys(keys);
   return True;
 }
 
+static Bool RimeProcessKeys(RimeSessionId session_id,
+                            const int* keycodes,
+                            const int* masks,
+                            size_t count) {
+  if (!keycodes && count > 0)
+    return False;
+  an<Session> session(Service::instance().GetSession(session_id));
+  if (!session)
+    return False;
+  KeySequence keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    keys.push_back(KeyEvent(keycodes[i], masks ? masks[i] : 0));
+  }
+  return Bool(session->ProcessKeys(keys));
+}
+
 RIME_DEPRECATED Bool RimeRunTask(const char* task_name) {
   if (!task_name)
     return False;
@@ -1182,6 +1197,7 @@ RIME_API RIME_FLAVORED(RimeApi) * RIME_FLAVORED(rime_get_api)() {
     s_api.config_next = &RimeConfigNext;
     s_api.config_end = &RimeConfigEnd;
     s_api.simulate_key_sequence = &RimeSimulateKeySequence;
+    s_api.process_keys = &RimeProcessKeys;
     s_api.register_module = &RimeRegisterModule;
     s_api.find_module = &RimeFindModule;
     s_api.run_task = &RimeRunTask;
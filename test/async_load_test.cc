@@ -0,0 +1,74 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+#include <rime_api.h>
+#include <rime/common.h>
+
+#include "test_helpers.h"
+
+using namespace rime;
+
+struct LoadNotifications {
+  vector<string> messages;
+  std::thread::id thread_id;
+};
+
+static void OnNotification(void* context_object,
+                           RimeSessionId session_id,
+                           const char* message_type,
+                           const char* message_value) {
+  if (string(message_type) != "load")
+    return;
+  auto* notifications = static_cast<LoadNotifications*>(context_object);
+  notifications->messages.push_back(message_value);
+  notifications->thread_id = std::this_thread::get_id();
+}
+
+class RimeAsyncLoadTest : public RimeSessionTestBase {
+ protected:
+  int NumCandidates(RimeSessionId session_id) {
+    int num_candidates = 0;
+    RIME_STRUCT(RimeContext, ctx);
+    if (rime_->get_context(session_id, &ctx)) {
+      num_candidates = ctx.menu.num_candidates;
+      rime_->free_context(&ctx);
+    }
+    return num_candidates;
+  }
+};
+
+TEST_F(RimeAsyncLoadTest, CandidatesShowOnceLoaded) {
+  LoadNotifications notifications;
+  rime_->set_notification_handler(&OnNotification, &notifications);
+  RimeSessionId session_id = rime_->create_session();
+  ASSERT_TRUE(rime_->select_schema(session_id, "async_load_test"));
+  // the same input may have been translated while loading
+  bool loaded = false;
+  for (int i = 0; i < 500 && !loaded; ++i) {
+    rime_->clear_composition(session_id);
+    rime_->simulate_key_sequence(session_id, "ba");
+    loaded = NumCandidates(session_id) > 0;
+    if (!loaded)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(loaded);
+  // delivers the notification, if loading finished during the last input
+  rime_->clear_composition(session_id);
+  // notified on the session's thread
+  ASSERT_EQ(1, notifications.messages.size());
+  EXPECT_EQ("dictionary_test/success", notifications.messages[0]);
+  EXPECT_EQ(std::this_thread::get_id(), notifications.thread_id);
+  rime_->destroy_session(session_id);
+  rime_->set_notification_handler(nullptr, nullptr);
+}
+
+TEST_F(RimeAsyncLoadTest, DestroySessionWhileLoading) {
+  RimeSessionId session_id = rime_->create_session();
+  ASSERT_TRUE(rime_->select_schema(session_id, "async_load_test"));
+  EXPECT_TRUE(rime_->destroy_session(session_id));
+}
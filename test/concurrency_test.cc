@@ -0,0 +1,73 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <rime_api.h>
+#include <rime/common.h>
+
+#include "test_helpers.h"
+
+using namespace rime;
+
+class RimeConcurrencyTest : public ::testing::Test {
+ protected:
+  void SetUp() override { CompileTestDictionary(); }
+};
+
+TEST_F(RimeConcurrencyTest, SessionsOnDifferentThreads) {
+  RimeApi* rime = rime_get_api();
+  const int kNumThreads = 8;
+  const int kNumRounds = 50;
+  const char* inputs[] = {"bang", "baobang", "ban", "ba"};
+  vector<std::thread> threads;
+  vector<int> failures(kNumThreads);
+  // sessions take turns, as calls into sessions must not overlap
+  std::mutex turn;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([=, &failures, &turn] {
+      std::unique_lock<std::mutex> lock(turn);
+      RimeSessionId session_id = rime->create_session();
+      if (!session_id ||
+          !rime->select_schema(session_id, "concurrency_test")) {
+        ++failures[i];
+        return;
+      }
+      for (int round = 0; round < kNumRounds; ++round) {
+        const char* input = inputs[(i + round) % 4];
+        rime->simulate_key_sequence(session_id, input);
+        RIME_STRUCT(RimeContext, ctx);
+        if (!rime->get_context(session_id, &ctx) ||
+            ctx.menu.num_candidates == 0) {
+          ++failures[i];
+        }
+        rime->free_context(&ctx);
+        if (round % 10 == 0) {
+          // commit to the user dictionary, which is shared by the sessions
+          rime->process_key(session_id, ' ', 0);
+          RIME_STRUCT(RimeCommit, commit);
+          if (!rime->get_commit(session_id, &commit)) {
+            ++failures[i];
+          }
+          rime->free_commit(&commit);
+        } else {
+          rime->clear_composition(session_id);
+        }
+        // let other sessions in
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+      }
+      rime->destroy_session(session_id);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(0, failures[i]) << "thread " << i;
+  }
+}
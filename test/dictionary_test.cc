@@ -5,7 +5,12 @@
 // 2011-07-05 GONG Chen <chen.sst@gmail.com>
 //
 #include <gtest/gtest.h>
+#include <fstream>
+#include <iterator>
 #include <rime/common.h>
+#include <rime/config.h>
+#include <rime/schema.h>
+#include <rime/ticket.h>
 #include <rime/algo/encoder.h>
 #include <rime/algo/syllabifier.h>
 #include <rime/dict/dictionary.h>
@@ -54,6 +59,53 @@ TEST_F(RimeDictionaryTest, SimpleLookup) {
   EXPECT_EQ("zhong", raw_code.ToString());
 }
 
+TEST_F(RimeDictionaryTest, FilteredLookup) {
+  ASSERT_TRUE(dict_->loaded());
+  rime::DictEntryIterator it;
+  dict_->LookupWords(&it, "zhong", false);
+  ASSERT_FALSE(it.exhausted());
+  size_t count = 0;
+  it.AddFilter([&count](const rime::DictEntryView& entry) {
+    ++count;
+    EXPECT_EQ(1u, entry.code->size());
+    return entry.text != "\xe4\xb8\xad";  // 中
+  });
+  EXPECT_GT(count, 0u);
+  while (!it.exhausted()) {
+    EXPECT_NE("\xe4\xb8\xad", it.Peek()->text);
+    it.Next();
+  }
+}
+
+TEST_F(RimeDictionaryTest, FilteredLookupOfEntries) {
+  ASSERT_TRUE(dict_->loaded());
+  rime::DictEntryIterator it;
+  dict_->LookupWords(&it, "zhong", false);
+  ASSERT_FALSE(it.exhausted());
+  // a filter of materialized entries, as plugins may add
+  rime::DictEntryFilter filter = [](rime::an<rime::DictEntry> entry) {
+    return entry->text != "\xe4\xb8\xad";  // 中
+  };
+  it.AddFilter(filter);
+  ASSERT_FALSE(it.exhausted());
+  while (!it.exhausted()) {
+    EXPECT_NE("\xe4\xb8\xad", it.Peek()->text);
+    it.Next();
+  }
+}
+
+TEST_F(RimeDictionaryTest, BlacklistedLookup) {
+  ASSERT_TRUE(dict_->loaded());
+  rime::hash_set<rime::string> blacklist{"\xe4\xb8\xad"};  // 中
+  rime::DictEntryIterator it;
+  dict_->LookupWords(&it, "zhong", false, 0, &blacklist);
+  ASSERT_FALSE(it.exhausted());
+  while (!it.exhausted()) {
+    EXPECT_NE("\xe4\xb8\xad", it.Peek()->text);
+    it.Next();
+  }
+}
+
 TEST_F(RimeDictionaryTest, PredictiveLookup) {
   ASSERT_TRUE(dict_->loaded());
   rime::DictEntryIterator it;
@@ -66,6 +118,31 @@ TEST_F(RimeDictionaryTest, PredictiveLookup) {
   EXPECT_EQ("za", raw_code.ToString());
 }
 
+TEST_F(RimeDictionaryTest, PredictiveLookupMergesChunksInOrder) {
+  ASSERT_TRUE(dict_->loaded());
+  rime::DictEntryIterator it;
+  dict_->LookupWords(&it, "z", true);
+  ASSERT_FALSE(it.exhausted());
+  size_t count = 1;
+  // entries are merged from chunks by remaining code length, then by weight
+  // once the iterator has advanced past the first entry.
+  ASSERT_TRUE(it.Next());
+  auto previous = it.Peek();
+  while (it.Next()) {
+    auto current = it.Peek();
+    ASSERT_TRUE(bool(current));
+    EXPECT_LE(previous->remaining_code_length,
+              current->remaining_code_length);
+    if (previous->remaining_code_length == current->remaining_code_length) {
+      EXPECT_GE(previous->weight, current->weight);
+    }
+    previous = current;
+    ++count;
+  }
+  EXPECT_EQ(it.entry_count(), count + 1);
+  EXPECT_TRUE(it.exhausted());
+}
+
 TEST_F(RimeDictionaryTest, ScriptLookup) {
   ASSERT_TRUE(dict_->loaded());
   rime::SyllableGraph g;
@@ -101,3 +178,91 @@ TEST_F(RimeDictionaryTest, ScriptLookup) {
   EXPECT_EQ(9, e3->text.length());
   EXPECT_FALSE(d7.Next());
 }
+
+// texts of the first few entries by start and end position
+static rime::map<rime::string, rime::vector<rime::string>> LookupTexts(
+    const rime::DictEntryGraph& lookups) {
+  rime::map<rime::string, rime::vector<rime::string>> texts;
+  for (const auto& x : lookups) {
+    for (auto& y : *x.second) {
+      auto key = std::to_string(x.first) + "-" + std::to_string(y.first);
+      auto& iter = y.second;
+      for (int i = 0; i < 5 && !iter.exhausted(); ++i, iter.Next()) {
+        texts[key].push_back(iter.Peek()->text);
+      }
+    }
+  }
+  return texts;
+}
+
+TEST_F(RimeDictionaryTest, GraphLookupAcrossEdits) {
+  ASSERT_TRUE(dict_->loaded());
+  const rime::vector<rime::string> inputs = {
+      "shu", "shuru", "shurufa", "shurufang", "shurufa", "shuru", "shurufa"};
+  rime::vector<rime::map<rime::string, rime::vector<rime::string>>> expected;
+  for (const auto& input : inputs) {
+    rime::SyllableGraph g;
+    rime::Syllabifier s;
+    ASSERT_TRUE(s.BuildSyllableGraph(input, *dict_->prism(), &g) > 0);
+    expected.push_back(LookupTexts(dict_->LookupGraph(g)));
+  }
+  rime::SyllableGraphCache cache;
+  rime::Syllabifier s;
+  s.EnableCache(&cache);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto g = s.BuildSyllableGraph(inputs[i], *dict_->prism());
+    ASSERT_TRUE(bool(g));
+    EXPECT_EQ(expected[i], LookupTexts(dict_->LookupGraph(*g))) << inputs[i];
+  }
+}
+
+TEST(RimeDictionaryComponentTest, AppliesLoadPolicyOfSchema) {
+  auto* config = new rime::Config;
+  // names not used by other tests, which would share the cached files
+  config->SetString("translator/dictionary", "load_policy_test");
+  config->SetBool("translator/load_policy/random_access", true);
+  config->SetBool("translator/load_policy/lock", true);
+  rime::Schema schema("load_policy_test", config);
+  rime::DictionaryComponent component;
+  rime::the<rime::Dictionary> dict(
+      component.Create(rime::Ticket(&schema, "translator")));
+  ASSERT_TRUE(dict);
+  auto expect_policy = [](const rime::MappedFileLoadPolicy& policy) {
+    EXPECT_FALSE(policy.prefetch);
+    EXPECT_TRUE(policy.random_access);
+    EXPECT_FALSE(policy.populate);
+    EXPECT_TRUE(policy.lock);
+    EXPECT_FALSE(policy.huge_pages);
+  };
+  expect_policy(dict->primary_table()->load_policy());
+  expect_policy(dict->prism()->load_policy());
+}
+
+static rime::string ReadFile(const rime::path& file_path) {
+  std::ifstream fin(file_path.c_str(), std::ios::binary);
+  return rime::string(std::istreambuf_iterator<char>(fin),
+                      std::istreambuf_iterator<char>());
+}
+
+TEST(RimeDictCompilerTest, ParallelBuildMatchesSequential) {
+  const rime::path files[] = {rime::path{"dictionary_test.table.bin"},
+                              rime::path{"dictionary_test.prism.bin"},
+                              rime::path{"dictionary_test.reverse.bin"}};
+  rime::vector<rime::string> built[2];
+  for (int i = 0; i < 2; ++i) {
+    rime::Dictionary dict("dictionary_test", {},
+                          {rime::New<rime::Table>(files[0])},
+                          rime::New<rime::Prism>(files[1]));
+    rime::DictCompiler dict_compiler(&dict);
+    dict_compiler.set_options(rime::DictCompiler::kRebuild |
+                              (i == 0 ? rime::DictCompiler::kSequential : 0));
+    ASSERT_TRUE(dict_compiler.Compile(rime::path()));  // no schema file
+    for (const auto& file : files) {
+      built[i].push_back(ReadFile(file));
+    }
+  }
+  for (size_t j = 0; j < built[0].size(); ++j) {
+    EXPECT_FALSE(built[0][j].empty()) << files[j];
+    EXPECT_TRUE(built[0][j] == built[1][j]) << files[j];
+  }
+}
@@ -0,0 +1,88 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <leveldb/filter_policy.h>
+#include <rime/config.h>
+#include <rime/dict/level_db.h>
+
+using namespace rime;
+
+class RimeLevelDbOptionsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    component_.reset(new ConfigComponent<ConfigLoader>);
+    config_.reset(component_->Create("level_db_test"));
+  }
+
+  the<Config::Component> component_;
+  the<Config> config_;
+};
+
+TEST_F(RimeLevelDbOptionsTest, SizesInMegabytes) {
+  auto options = LoadLevelDbOptions(config_.get(), "userdb");
+  EXPECT_EQ(size_t(8) << 20, options.block_cache_size);
+  EXPECT_EQ(size_t(4) << 20, options.write_buffer_size);
+  EXPECT_EQ(10, options.bloom_filter_bits);
+  EXPECT_FALSE(options.compression);
+  EXPECT_TRUE(options.fill_cache);
+}
+
+TEST_F(RimeLevelDbOptionsTest, UnsetOptionsKeepDefaults) {
+  const LevelDbOptions defaults;
+  auto options = LoadLevelDbOptions(config_.get(), "partial");
+  EXPECT_EQ(12, options.bloom_filter_bits);
+  EXPECT_EQ(defaults.block_cache_size, options.block_cache_size);
+  EXPECT_EQ(defaults.write_buffer_size, options.write_buffer_size);
+  EXPECT_EQ(defaults.compression, options.compression);
+  EXPECT_EQ(defaults.fill_cache, options.fill_cache);
+  // sizes that are not positive keep the defaults, too
+  options = LoadLevelDbOptions(config_.get(), "invalid");
+  EXPECT_EQ(defaults.block_cache_size, options.block_cache_size);
+  EXPECT_EQ(defaults.write_buffer_size, options.write_buffer_size);
+  // so do all options of an unknown class of dbs
+  options = LoadLevelDbOptions(config_.get(), "unknown");
+  EXPECT_EQ(defaults.block_cache_size, options.block_cache_size);
+  EXPECT_EQ(defaults.bloom_filter_bits, options.bloom_filter_bits);
+  EXPECT_EQ(defaults.write_buffer_size, options.write_buffer_size);
+  EXPECT_EQ(defaults.compression, options.compression);
+  EXPECT_EQ(defaults.fill_cache, options.fill_cache);
+}
+
+TEST(RimeLevelDbTest, SharesBlockCacheOfClass) {
+  LevelDbOptions options;
+  options.block_cache_size = size_t(1) << 20;
+  options.bloom_filter_bits = 10;
+  LevelDb::set_class_options("level_db_test", options);
+  LevelDb db1(path{"level_db_test_1.userdb"}, "level_db_test_1",
+              "level_db_test");
+  LevelDb db2(path{"level_db_test_2.userdb"}, "level_db_test_2",
+              "level_db_test");
+  ASSERT_TRUE(db1.Open());
+  ASSERT_TRUE(db2.Open());
+  ASSERT_TRUE(db1.block_cache() != nullptr);
+  EXPECT_EQ(db1.block_cache(), db2.block_cache());
+  ASSERT_TRUE(db1.filter_policy() != nullptr);
+  EXPECT_STREQ("leveldb.BuiltinBloomFilter2", db1.filter_policy()->Name());
+  EXPECT_EQ(db1.filter_policy(), db2.filter_policy());
+  // a db with options of its own does not share the cache
+  LevelDb db3(path{"level_db_test_3.userdb"}, "level_db_test_3",
+              "level_db_test");
+  db3.set_options(options);
+  ASSERT_TRUE(db3.Open());
+  ASSERT_TRUE(db3.block_cache() != nullptr);
+  EXPECT_NE(db1.block_cache(), db3.block_cache());
+  // reads go through the cache and filter
+  EXPECT_TRUE(db1.Update("key", "value"));
+  string value;
+  EXPECT_TRUE(db1.Fetch("key", &value));
+  EXPECT_EQ("value", value);
+  EXPECT_FALSE(db1.Fetch("missing", &value));
+  for (LevelDb* db : {&db1, &db2, &db3}) {
+    EXPECT_TRUE(db->Close());
+    EXPECT_EQ(nullptr, db->block_cache());
+    EXPECT_TRUE(db->Remove());
+  }
+}
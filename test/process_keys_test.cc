@@ -0,0 +1,102 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <rime_api.h>
+#include <rime/common.h>
+#include <rime/composition.h>
+#include <rime/context.h>
+#include <rime/key_event.h>
+#include <rime/menu.h>
+#include <rime/service.h>
+
+#include "test_helpers.h"
+
+using namespace rime;
+
+class RimeProcessKeysTest : public RimeSessionTestBase {
+ protected:
+  string GetSnapshot(RimeSessionId session_id) {
+    string snapshot;
+    RIME_STRUCT(RimeContext, ctx);
+    if (rime_->get_context(session_id, &ctx)) {
+      if (ctx.composition.preedit)
+        snapshot += ctx.composition.preedit;
+      for (int i = 0; i < ctx.menu.num_candidates; ++i) {
+        snapshot += string("|") + ctx.menu.candidates[i].text;
+      }
+      rime_->free_context(&ctx);
+    }
+    RIME_STRUCT(RimeCommit, commit);
+    if (rime_->get_commit(session_id, &commit)) {
+      snapshot += string("<") + commit.text;
+      rime_->free_commit(&commit);
+    }
+    return snapshot;
+  }
+};
+
+TEST_F(RimeProcessKeysTest, SameAsProcessingOneByOne) {
+  const char* sequences[] = {
+      "baobang",
+      "baoban{BackSpace}g",
+      "ban{space}ba",
+      "bao'ban{Left}{Left}",
+      "bangbang2",
+  };
+  for (const char* sequence : sequences) {
+    SCOPED_TRACE(sequence);
+    KeySequence keys;
+    ASSERT_TRUE(keys.Parse(sequence));
+    vector<int> keycodes;
+    vector<int> masks;
+    RimeSessionId one_by_one = CreateSession();
+    for (const KeyEvent& key : keys) {
+      rime_->process_key(one_by_one, key.keycode(), key.modifier());
+      keycodes.push_back(key.keycode());
+      masks.push_back(key.modifier());
+    }
+    RimeSessionId batch = CreateSession();
+    ASSERT_TRUE(RIME_API_AVAILABLE(rime_, process_keys));
+    rime_->process_keys(batch, keycodes.data(), masks.data(), keys.size());
+    string expected = GetSnapshot(one_by_one);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, GetSnapshot(batch));
+    rime_->destroy_session(one_by_one);
+    rime_->destroy_session(batch);
+  }
+}
+
+TEST_F(RimeProcessKeysTest, RejectsMissingKeycodes) {
+  RimeSessionId session_id = CreateSession();
+  ASSERT_TRUE(RIME_API_AVAILABLE(rime_, process_keys));
+  EXPECT_FALSE(rime_->process_keys(session_id, nullptr, nullptr, 1));
+  EXPECT_TRUE(rime_->process_keys(session_id, nullptr, nullptr, 0));
+  rime_->destroy_session(session_id);
+}
+
+TEST_F(RimeProcessKeysTest, DeferredMenuOutlivesSession) {
+  RimeSessionId session_id = CreateSession();
+  KeySequence keys;
+  ASSERT_TRUE(keys.Parse("baobang"));
+  vector<int> keycodes;
+  vector<int> masks;
+  for (const KeyEvent& key : keys) {
+    keycodes.push_back(key.keycode());
+    masks.push_back(key.modifier());
+  }
+  ASSERT_TRUE(RIME_API_AVAILABLE(rime_, process_keys));
+  rime_->process_keys(session_id, keycodes.data(), masks.data(), keys.size());
+  auto session = Service::instance().GetSession(session_id);
+  ASSERT_TRUE(session);
+  Composition& comp = session->context()->composition();
+  ASSERT_FALSE(comp.empty());
+  an<Menu> menu = comp.back().menu;
+  ASSERT_TRUE(menu);
+  session.reset();
+  rime_->destroy_session(session_id);
+  // the pending translation is dropped along with the engine.
+  EXPECT_EQ(0u, menu->Prepare(1));
+}
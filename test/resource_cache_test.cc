@@ -0,0 +1,95 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <rime/common.h>
+#include <rime/resource_cache.h>
+
+using namespace rime;
+
+struct Resource {
+  string name;
+  size_t size;
+};
+
+static size_t SizeOf(const Resource& resource) {
+  return resource.size;
+}
+
+static ResourceCache<Resource>::Creator Creator(const string& name,
+                                                size_t size = 100) {
+  return [=] { return New<Resource>(Resource{name, size}); };
+}
+
+TEST(RimeResourceCacheTest, SharedWithoutRetention) {
+  ResourceCache<Resource> cache(SizeOf);
+  cache.set_retention({});
+  auto a = cache.Get("a", Creator("a"));
+  ASSERT_TRUE(bool(a));
+  EXPECT_EQ(a, cache.Get("a", Creator("a")));
+  weak<Resource> released = a;
+  a.reset();
+  EXPECT_TRUE(released.expired());
+  auto b = cache.Get("a", Creator("a"));
+  auto stats = cache.stats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(0, stats.revivals);
+  EXPECT_EQ(1, stats.loads);
+  EXPECT_EQ(1, stats.reloads);
+}
+
+TEST(RimeResourceCacheTest, RetainedWithinBudget) {
+  ResourceCache<Resource> cache(SizeOf);
+  ResourceRetention retention;
+  retention.memory_budget = 250;
+  cache.set_retention(retention);
+  weak<Resource> a = cache.Get("a", Creator("a"));
+  weak<Resource> b = cache.Get("b", Creator("b"));
+  EXPECT_FALSE(a.expired());
+  EXPECT_FALSE(b.expired());
+  EXPECT_TRUE(bool(cache.Get("a", Creator("a"))));
+  // evicts the least recently acquired one, b
+  weak<Resource> c = cache.Get("c", Creator("c"));
+  EXPECT_FALSE(a.expired());
+  EXPECT_TRUE(b.expired());
+  EXPECT_FALSE(c.expired());
+  auto stats = cache.stats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.revivals);
+  EXPECT_EQ(3, stats.loads);
+  EXPECT_EQ(1, stats.evictions);
+
+  // resources in use stay alive regardless
+  auto big = cache.Get("big", Creator("big", 1000));
+  EXPECT_TRUE(a.expired());
+  EXPECT_TRUE(c.expired());
+  EXPECT_EQ(big, cache.Get("big", Creator("big")));
+
+  cache.set_retention({});
+  EXPECT_TRUE(bool(big));
+  weak<Resource> released = big;
+  big.reset();
+  EXPECT_TRUE(released.expired());
+}
+
+TEST(RimeResourceCacheTest, ReleaseAllRetained) {
+  ResourceCache<Resource> cache(SizeOf);
+  ResourceRetention retention;
+  retention.memory_budget = 250;
+  cache.set_retention(retention);
+  weak<Resource> a = cache.Get("a", Creator("a"));
+  auto b = cache.Get("b", Creator("b"));
+  // within the limits
+  ResourceCacheBase::TrimAll();
+  EXPECT_FALSE(a.expired());
+  // as before deployment
+  ResourceCacheBase::ReleaseAllRetained();
+  EXPECT_TRUE(a.expired());
+  EXPECT_TRUE(bool(b));
+  weak<Resource> released = b;
+  b.reset();
+  EXPECT_TRUE(released.expired());
+  EXPECT_EQ(2, cache.stats().evictions);
+}
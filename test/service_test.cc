@@ -0,0 +1,56 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <rime/common.h>
+#include <rime/service.h>
+
+using namespace rime;
+
+TEST(RimeServiceTest, ConcurrentSessions) {
+  auto& service = Service::instance();
+  const int kNumThreads = 4;
+  const int kNumSessions = 8;
+  vector<std::thread> threads;
+  vector<int> failures(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&service, &failures, i] {
+      vector<SessionId> ids;
+      for (int j = 0; j < kNumSessions; ++j) {
+        ids.push_back(service.CreateSession());
+      }
+      for (auto id : ids) {
+        if (!service.GetSession(id))
+          ++failures[i];
+      }
+      for (auto id : ids) {
+        if (!service.DestroySession(id) || service.GetSession(id))
+          ++failures[i];
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (int n : failures) {
+    EXPECT_EQ(0, n);
+  }
+}
+
+TEST(RimeServiceTest, CleanupSessions) {
+  auto& service = Service::instance();
+  SessionId id = service.CreateSession();
+  ASSERT_NE(kInvalidSessionId, id);
+  auto session = service.GetSession(id);
+  ASSERT_TRUE(bool(session));
+  // recently active
+  service.CleanupStaleSessions();
+  EXPECT_TRUE(bool(service.GetSession(id)));
+  service.CleanupAllSessions();
+  EXPECT_FALSE(bool(service.GetSession(id)));
+  // still usable by the holder
+  EXPECT_TRUE(session->context() != nullptr);
+}
@@ -0,0 +1,110 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <utf8.h>
+#include <rime/common.h>
+#include <rime/algo/strings.h>
+
+using namespace rime;
+
+TEST(RimeStringsTest, Split) {
+  auto tokens = strings::split("a\tbc\t\td", "\t");
+  ASSERT_EQ(4, tokens.size());
+  EXPECT_EQ("bc", tokens[1]);
+  EXPECT_EQ("", tokens[2]);
+  tokens = strings::split(" a, b ,c", " ,", strings::SplitBehavior::SkipToken);
+  ASSERT_EQ(3, tokens.size());
+  EXPECT_EQ("a", tokens[0]);
+  EXPECT_EQ("b", tokens[1]);
+  EXPECT_EQ("c", tokens[2]);
+  EXPECT_TRUE(
+      strings::split(" ,", " ,", strings::SplitBehavior::SkipToken).empty());
+}
+
+TEST(RimeStringsTest, Utf8Length) {
+  EXPECT_EQ(0, strings::utf8_length(""));
+  EXPECT_EQ(3, strings::utf8_length("abc"));
+  // longer than a vector register, mixing 1 to 4 byte sequences
+  string text = "中華人民共和國 zhong hua \xF0\x9F\x98\x80 é 漢字";
+  text += text;
+  EXPECT_EQ(utf8::unchecked::distance(text.begin(), text.end()),
+            strings::utf8_length(text));
+  // long enough for the per byte counters to be summed up more than once
+  string long_text;
+  for (int i = 0; i < 200; ++i) {
+    long_text += text;
+  }
+  EXPECT_EQ(utf8::unchecked::distance(long_text.begin(), long_text.end()),
+            strings::utf8_length(long_text));
+}
+
+TEST(RimeStringsTest, Utf8Valid) {
+  EXPECT_TRUE(strings::utf8_valid(""));
+  EXPECT_TRUE(strings::utf8_valid("zhonghuarenmingongheguo"));
+  string text = "中華人民共和國 zhong hua \xF0\x9F\x98\x80 é 漢字";
+  EXPECT_TRUE(strings::utf8_valid(text));
+  EXPECT_TRUE(strings::utf8_valid("\xED\x9F\xBF\xEE\x80\x80"));  // U+D7FF
+  EXPECT_TRUE(strings::utf8_valid("\xF4\x8F\xBF\xBF"));  // U+10FFFF
+  const char* invalid[] = {
+      "\x80",              // continuation byte
+      "\xE4\xB8",          // truncated
+      "\xE4\x41\xAD",      // not a continuation byte
+      "\xC0\x80",          // overlong
+      "\xE0\x80\x80",      // overlong
+      "\xF0\x80\x80\x80",  // overlong
+      "\xED\xA0\x80",      // surrogate
+      "\xF4\x90\x80\x80",  // beyond U+10FFFF
+      "\xF5\x80\x80\x80",
+      "\xFF",
+  };
+  for (const char* s : invalid) {
+    SCOPED_TRACE(s);
+    EXPECT_FALSE(strings::utf8_valid(s));
+    // found after runs of ASCII characters of any length
+    for (size_t n = 1; n <= 40; ++n) {
+      string ascii(n, 'a');
+      EXPECT_FALSE(strings::utf8_valid(ascii + s));
+      EXPECT_FALSE(strings::utf8_valid(ascii + s + ascii));
+      EXPECT_FALSE(strings::utf8_valid(text + ascii + s));
+    }
+  }
+}
+
+TEST(RimeStringsTest, Utf8ValidSameAsUtfCpp) {
+  // pseudo-random bytes, mostly ASCII, with some lead and continuation bytes
+  const unsigned char kBytes[] = {'a',  'b',  ' ',  '1',  0x80, 0xA0,
+                                  0xBF, 0xC2, 0xDF, 0xE0, 0xE4, 0xED,
+                                  0xEF, 0xF0, 0xF4, 0xF5};
+  uint32_t seed = 12345;
+  for (int i = 0; i < 10000; ++i) {
+    string s;
+    size_t length = i % 40;
+    for (size_t j = 0; j < length; ++j) {
+      seed = seed * 1103515245 + 12345;
+      int r = (seed >> 16) & 0x7FFF;
+      s += static_cast<char>(r % 3 ? 'a' + r % 26 : kBytes[r % 16]);
+    }
+    EXPECT_EQ(utf8::is_valid(s.begin(), s.end()), strings::utf8_valid(s))
+        << testing::PrintToString(s);
+  }
+}
+
+TEST(RimeStringsTest, IsAscii) {
+  EXPECT_TRUE(strings::is_ascii(""));
+  EXPECT_TRUE(strings::is_ascii("zhonghuarenmingongheguo"));
+  EXPECT_FALSE(strings::is_ascii("zhonghuarenmingongheguo中"));
+  EXPECT_FALSE(strings::is_ascii("中zhonghuarenmingongheguo"));
+}
+
+TEST(RimeStringsTest, ByteSet) {
+  strings::ByteSet delimiters(" '\x80");
+  EXPECT_TRUE(delimiters.contains('\''));
+  EXPECT_TRUE(delimiters.contains('\x80'));
+  EXPECT_FALSE(delimiters.contains('a'));
+  EXPECT_EQ(2, delimiters.find_in("xi'an"));
+  EXPECT_EQ(2, delimiters.find_not_in("  a "));
+  EXPECT_EQ(string::npos, delimiters.find_in("xian"));
+}
@@ -152,11 +152,132 @@ TEST_F(RimeSyllabifierTest, TransposedSyllableGraph) {
   rime::SyllableGraph g;
   const rime::string input("changan");
   s.BuildSyllableGraph(input, *prism_, &g);
-  ASSERT_FALSE(g.indices.end() == g.indices.find(0));
-  EXPECT_EQ(2, g.indices[0].size());
-  EXPECT_FALSE(g.indices[0].end() == g.indices[0].find(syllable_id_["chan"]));
-  EXPECT_FALSE(g.indices[0].end() == g.indices[0].find(syllable_id_["chang"]));
-  ASSERT_EQ(1, g.indices[0][syllable_id_["chan"]].size());
-  ASSERT_FALSE(NULL == g.indices[0][syllable_id_["chan"]][0]);
-  EXPECT_EQ(4, g.indices[0][syllable_id_["chan"]][0]->end_pos);
+  auto index = g.indices.find(0);
+  ASSERT_FALSE(NULL == index);
+  EXPECT_EQ(2, index->size());
+  auto chan = index->find(syllable_id_["chan"]);
+  ASSERT_FALSE(index->end() == chan);
+  EXPECT_FALSE(index->end() == index->find(syllable_id_["chang"]));
+  ASSERT_EQ(1, chan->spellings.size());
+  ASSERT_FALSE(NULL == chan->spellings[0]);
+  EXPECT_EQ(4, chan->spellings[0]->end_pos);
+}
+
+TEST_F(RimeSyllabifierTest, MovedSyllableGraph) {
+  rime::Syllabifier s;
+  rime::SyllableGraph g;
+  const rime::string input("changan");
+  s.BuildSyllableGraph(input, *prism_, &g);
+  rime::SyllableGraph moved(std::move(g));
+  auto index = moved.indices.find(0);
+  ASSERT_FALSE(NULL == index);
+  auto chan = index->find(syllable_id_["chan"]);
+  ASSERT_FALSE(index->end() == chan);
+  ASSERT_EQ(1, chan->spellings.size());
+  // the edge is the one held by the moved graph
+  EXPECT_EQ(&moved.edges[0][4][syllable_id_["chan"]], chan->spellings[0]);
+}
+
+TEST_F(RimeSyllabifierTest, CopiedSyllableGraph) {
+  rime::Syllabifier s;
+  rime::SyllableGraph g;
+  const rime::string input("changan");
+  s.BuildSyllableGraph(input, *prism_, &g);
+  rime::SyllableGraph copied(g);
+  g = rime::SyllableGraph();
+  EXPECT_EQ(input.length(), copied.input_length);
+  auto index = copied.indices.find(0);
+  ASSERT_FALSE(NULL == index);
+  auto chan = index->find(syllable_id_["chan"]);
+  ASSERT_FALSE(index->end() == chan);
+  ASSERT_EQ(1, chan->spellings.size());
+  // indices are rebuilt for the copied edges
+  EXPECT_EQ(&copied.edges[0][4][syllable_id_["chan"]], chan->spellings[0]);
+  rime::SyllableGraph assigned;
+  assigned = copied;
+  EXPECT_EQ(copied.vertices, assigned.vertices);
+  EXPECT_FALSE(NULL == assigned.indices.find(0));
+}
+
+static void ExpectSameGraph(const rime::SyllableGraph& expected,
+                            const rime::SyllableGraph& actual) {
+  EXPECT_EQ(expected.input_length, actual.input_length);
+  EXPECT_EQ(expected.interpreted_length, actual.interpreted_length);
+  EXPECT_EQ(expected.vertices, actual.vertices);
+  ASSERT_EQ(expected.edges.size(), actual.edges.size());
+  for (const auto& start : expected.edges) {
+    auto a = actual.edges.find(start.first);
+    ASSERT_FALSE(actual.edges.end() == a);
+    ASSERT_EQ(start.second.size(), a->second.size());
+    for (const auto& end : start.second) {
+      auto b = a->second.find(end.first);
+      ASSERT_FALSE(a->second.end() == b);
+      ASSERT_EQ(end.second.size(), b->second.size());
+      for (const auto& spelling : end.second) {
+        auto c = b->second.find(spelling.first);
+        ASSERT_FALSE(b->second.end() == c);
+        EXPECT_EQ(spelling.second.type, c->second.type);
+        EXPECT_EQ(spelling.second.end_pos, c->second.end_pos);
+        EXPECT_EQ(spelling.second.ambiguous_source_positions,
+                  c->second.ambiguous_source_positions);
+      }
+    }
+  }
+}
+
+TEST_F(RimeSyllabifierTest, IncrementalBuild) {
+  rime::SyllableGraphCache cache;
+  const char* inputs[] = {
+      "c",     "ch",     "cha",     "chan",    "chang",     "changa", "changan",
+      "changa", "chang", "changt", "changtu", "changtuan", "a",      "an'",
+  };
+  rime::an<const rime::SyllableGraph> last_graph;
+  rime::SyllableGraph last_expected;
+  for (const char* input : inputs) {
+    SCOPED_TRACE(input);
+    rime::Syllabifier s("'", true);
+    s.EnableCache(&cache);
+    auto g = s.BuildSyllableGraph(input, *prism_);
+    ASSERT_TRUE(bool(g));
+    rime::Syllabifier t("'", true);
+    rime::SyllableGraph expected;
+    t.BuildSyllableGraph(input, *prism_, &expected);
+    ExpectSameGraph(expected, *g);
+    // the graph built before is left intact
+    if (last_graph) {
+      EXPECT_NE(last_graph, g);
+      ExpectSameGraph(last_expected, *last_graph);
+    }
+    last_graph = g;
+    last_expected = std::move(expected);
+  }
+}
+
+TEST_F(RimeSyllabifierTest, StableLength) {
+  rime::SyllableGraphCache cache;
+  rime::Syllabifier s;
+  s.EnableCache(&cache);
+  auto g1 = s.BuildSyllableGraph("changan", *prism_);
+  EXPECT_EQ(0, g1->stable_length);
+  size_t revision = g1->revision;
+  // the graph in use is left intact, and a new one is built
+  auto g2 = s.BuildSyllableGraph("changantu", *prism_);
+  EXPECT_NE(g1, g2);
+  EXPECT_EQ(revision, g1->revision);
+  EXPECT_EQ(revision, g2->previous_revision);
+  EXPECT_EQ(7, g1->input_length);
+  EXPECT_EQ(9, g2->input_length);
+  // chan'gan, chang'an
+  EXPECT_EQ(7, g2->stable_length);
+  auto g3 = s.BuildSyllableGraph("changantu", *prism_);
+  EXPECT_EQ(g3->interpreted_length, g3->stable_length);
+  // no further than the part of input left unchanged
+  auto g4 = s.BuildSyllableGraph("chenganm", *prism_);
+  EXPECT_GE(2, g4->stable_length);
+  // revisions are counted by each cache
+  EXPECT_EQ(g3->revision + 1, g4->revision);
+  rime::SyllableGraphCache another_cache;
+  rime::Syllabifier t;
+  t.EnableCache(&another_cache);
+  EXPECT_EQ(1, t.BuildSyllableGraph("changan", *prism_)->revision);
 }
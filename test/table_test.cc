@@ -4,6 +4,8 @@
 //
 // 2011-07-03 GONG Chen <chen.sst@gmail.com>
 //
+#include <cmath>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <rime/algo/syllabifier.h>
 #include <rime/dict/table.h>
@@ -97,6 +99,34 @@ TEST_F(RimeTableTest, IntegrityTest) {
   ASSERT_TRUE(table_->Load());
 }
 
+TEST_F(RimeTableTest, LoadWithPolicy) {
+  rime::MappedFileLoadPolicy policy;
+  policy.prefetch = true;
+  policy.random_access = true;
+  policy.populate = true;
+  policy.lock = true;
+  policy.huge_pages = true;
+  table_->set_load_policy(policy);
+  // the hints do not change what is read
+  ASSERT_TRUE(table_->Load());
+  rime::TableAccessor v = table_->QueryWords(2);
+  ASSERT_EQ(3, v.remaining());
+  EXPECT_STREQ("er", Text(v).c_str());
+  table_->set_load_policy({});
+}
+
+TEST_F(RimeTableTest, EntryTextView) {
+  ASSERT_TRUE(table_->has_string_pool());
+  rime::TableAccessor v = table_->QueryWords(2);
+  rime::string buffer;
+  EXPECT_EQ("er", table_->GetEntryTextView(*v.entry(), &buffer));
+  // read in place
+  EXPECT_TRUE(buffer.empty());
+  v.Next();
+  EXPECT_EQ("liang", table_->GetEntryTextView(*v.entry(), &buffer));
+  EXPECT_EQ("liang", Text(v));
+}
+
 TEST_F(RimeTableTest, SimpleQuery) {
   EXPECT_STREQ("0", table_->GetSyllableById(0).c_str());
   EXPECT_STREQ("3", table_->GetSyllableById(3).c_str());
@@ -172,10 +202,7 @@ TEST_F(RimeTableTest, QueryWithSyllableGraph) {
   g.edges[4][7][3].end_pos = 7;
   g.edges[7][9][4].type = rime::kNormalSpelling;
   g.edges[7][9][4].end_pos = 9;
-  g.indices[0][1].push_back(&g.edges[0][2][1]);
-  g.indices[2][2].push_back(&g.edges[2][4][2]);
-  g.indices[4][3].push_back(&g.edges[4][7][3]);
-  g.indices[7][4].push_back(&g.edges[7][9][4]);
+  g.indices.Build(g.edges);
 
   rime::TableQueryResult result;
   ASSERT_TRUE(table_->Query(g, 0, &result));
@@ -203,3 +230,214 @@ TEST_F(RimeTableTest, QueryWithSyllableGraph) {
   EXPECT_STREQ("lia", Text(result[4].front()).c_str());
   EXPECT_FALSE(result[4].front().Next());
 }
+
+TEST_F(RimeTableTest, QueryResultInOrderOfEndPosition) {
+  // "yi" at [0, 4) is found before "er" at [0, 2)
+  rime::SyllableGraph g;
+  g.input_length = 4;
+  g.interpreted_length = g.input_length;
+  g.edges[0][4][1].type = rime::kNormalSpelling;
+  g.edges[0][4][1].end_pos = 4;
+  g.edges[0][2][2].type = rime::kNormalSpelling;
+  g.edges[0][2][2].end_pos = 2;
+  g.indices.Build(g.edges);
+
+  rime::TableQueryResult result;
+  ASSERT_TRUE(table_->Query(g, 0, &result));
+  ASSERT_EQ(2, result.size());
+  auto it = result.begin();
+  EXPECT_EQ(2, it->first);
+  ASSERT_EQ(1, it->second.size());
+  EXPECT_STREQ("er", Text(it->second.front()).c_str());
+  ++it;
+  EXPECT_EQ(4, it->first);
+  ASSERT_EQ(1, it->second.size());
+  EXPECT_STREQ("yi", Text(it->second.front()).c_str());
+  EXPECT_EQ(1, it->second.front().index_code_size());
+  EXPECT_TRUE(result.find(3) == result.end());
+  EXPECT_TRUE(result.find(4) != result.end());
+  // as with the map it used to be
+  const rime::TableQueryResult& const_result = result;
+  EXPECT_EQ(1, const_result.count(2));
+  EXPECT_EQ(0, const_result.count(3));
+  EXPECT_TRUE(const_result.find(4) != const_result.end());
+  EXPECT_EQ(4, const_result.rbegin()->first);
+}
+
+TEST(RimeTableFormatTest, WideTrunkIndex) {
+  const rime::path file_path{"table_test_wide.bin"};
+  const int kNumSyllables = 100;
+  auto code = [](std::initializer_list<rime::SyllableId> ids) {
+    rime::Code c;
+    c.assign(ids);
+    return c;
+  };
+  rime::Syllabary syll;
+  rime::Vocabulary voc;
+  size_t num_entries = 0;
+  for (int i = 0; i < kNumSyllables; ++i) {
+    syll.insert(std::to_string(1000 + i));
+  }
+  // phrases of 2 syllables "1 x" for even x, and of 3 syllables "1 2 y"
+  // for y divisible by 3.
+  auto lv2 = rime::New<rime::Vocabulary>();
+  voc[1].next_level = lv2;
+  for (int x = 0; x < kNumSyllables; x += 2) {
+    auto d = rime::New<rime::ShortDictEntry>();
+    d->code = code({1, x});
+    d->text = "1-" + std::to_string(x);
+    (*lv2)[x].entries.push_back(d);
+    ++num_entries;
+  }
+  auto lv3 = rime::New<rime::Vocabulary>();
+  (*lv2)[2].next_level = lv3;
+  for (int y = 0; y < kNumSyllables; y += 3) {
+    auto d = rime::New<rime::ShortDictEntry>();
+    d->code = code({1, 2, y});
+    d->text = "1-2-" + std::to_string(y);
+    (*lv3)[y].entries.push_back(d);
+    ++num_entries;
+  }
+  {
+    rime::Table table(file_path);
+    table.Remove();
+    ASSERT_TRUE(table.Build(syll, voc, num_entries));
+    ASSERT_TRUE(table.Save());
+  }
+  auto verify = [&](rime::Table& table) {
+    for (int x = -1; x <= kNumSyllables; ++x) {
+      auto v = table.QueryPhrases(code({1, x}));
+      if (x >= 0 && x < kNumSyllables && x % 2 == 0) {
+        ASSERT_FALSE(v.exhausted()) << x;
+        EXPECT_EQ("1-" + std::to_string(x), table.GetEntryText(*v.entry()));
+      } else {
+        EXPECT_TRUE(v.exhausted()) << x;
+      }
+    }
+    for (int y = -1; y <= kNumSyllables; ++y) {
+      auto v = table.QueryPhrases(code({1, 2, y}));
+      if (y >= 0 && y < kNumSyllables && y % 3 == 0) {
+        ASSERT_FALSE(v.exhausted()) << y;
+        EXPECT_EQ("1-2-" + std::to_string(y), table.GetEntryText(*v.entry()));
+      } else {
+        EXPECT_TRUE(v.exhausted()) << y;
+      }
+    }
+  };
+  {
+    rime::Table table(file_path);
+    ASSERT_TRUE(table.Load());
+    EXPECT_STREQ("Rime::Table/5.0", table.metadata()->format);
+    EXPECT_FALSE(table.outdated());
+    verify(table);
+  }
+  // a table of format v4.0 is searched without the hash tables.
+  {
+    std::fstream file(file_path.c_str(),
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekp(0);
+    file.write("Rime::Table/4.0", 15);
+  }
+  {
+    rime::Table table(file_path);
+    ASSERT_TRUE(table.Load());
+    EXPECT_STREQ("Rime::Table/4.0", table.metadata()->format);
+    EXPECT_TRUE(table.outdated());
+    verify(table);
+  }
+  // tables of the next major version are refused.
+  {
+    std::fstream file(file_path.c_str(),
+                      std::ios::in | std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file.seekp(0);
+    file.write("Rime::Table/6.0", 15);
+  }
+  {
+    rime::Table table(file_path);
+    EXPECT_FALSE(table.Load());
+  }
+}
+
+TEST(RimeTableFormatTest, CompactTable) {
+  rime::Syllabary syll;
+  rime::Vocabulary voc;
+  const int kNumEntries = 300;
+  syll.insert("a");
+  syll.insert("b");
+  // a long list of homophones, and phrases of 2 and 4 syllables
+  for (int i = 0; i < kNumEntries; ++i) {
+    auto d = rime::New<rime::ShortDictEntry>();
+    d->code.push_back(0);
+    d->text = "a" + std::to_string(i);
+    d->weight = std::log(1000.0 / (i + 1));
+    voc[0].entries.push_back(d);
+  }
+  auto lv2 = rime::New<rime::Vocabulary>();
+  voc[0].next_level = lv2;
+  auto d = rime::New<rime::ShortDictEntry>();
+  d->code.push_back(0);
+  d->code.push_back(1);
+  d->text = "ab";
+  d->weight = -1.5;
+  (*lv2)[1].entries.push_back(d);
+  auto lv3 = rime::New<rime::Vocabulary>();
+  (*lv2)[1].next_level = lv3;
+  auto lv4 = rime::New<rime::Vocabulary>();
+  (*lv3)[0].next_level = lv4;
+  d = rime::New<rime::ShortDictEntry>(*d);
+  d->code.push_back(0);
+  d->code.push_back(1);
+  d->text = "abab";
+  d->weight = 2.25;
+  (*lv4)[-1].entries.push_back(d);
+
+  rime::Table plain(rime::path{"table_test_plain.bin"});
+  plain.Remove();
+  ASSERT_TRUE(plain.Build(syll, voc, kNumEntries + 2));
+  ASSERT_TRUE(plain.Save());
+  rime::Table compact(rime::path{"table_test_compact.bin"});
+  compact.Remove();
+  ASSERT_TRUE(compact.Build(syll, voc, kNumEntries + 2, 0, true));
+  ASSERT_TRUE(compact.Save());
+  ASSERT_TRUE(plain.Load());
+  ASSERT_TRUE(compact.Load());
+  EXPECT_FALSE(plain.metadata()->packed_entries);
+  EXPECT_TRUE(compact.metadata()->packed_entries);
+  EXPECT_LT(compact.file_size(), plain.file_size());
+  EXPECT_TRUE(plain.has_string_pool());
+  EXPECT_FALSE(compact.has_string_pool());
+
+  auto expect_same = [&](rime::TableAccessor a, rime::TableAccessor b) {
+    ASSERT_EQ(a.remaining(), b.remaining());
+    while (!a.exhausted()) {
+      ASSERT_FALSE(b.exhausted());
+      EXPECT_EQ(plain.GetEntryText(*a.entry()),
+                compact.GetEntryText(*b.entry()));
+      EXPECT_NEAR(a.entry()->weight, b.entry()->weight, 1.0 / 2048);
+      EXPECT_EQ(a.code(), b.code());
+      a.Next();
+      b.Next();
+    }
+    EXPECT_TRUE(b.exhausted());
+  };
+  expect_same(plain.QueryWords(0), compact.QueryWords(0));
+  rime::Code code;
+  code.push_back(0);
+  code.push_back(1);
+  expect_same(plain.QueryPhrases(code), compact.QueryPhrases(code));
+  code.push_back(0);
+  code.push_back(1);
+  expect_same(plain.QueryPhrases(code), compact.QueryPhrases(code));
+
+  auto a = compact.QueryWords(0);
+  EXPECT_TRUE(a.Skip(kNumEntries - 1));
+  EXPECT_EQ(1, a.remaining());
+  EXPECT_EQ("a" + std::to_string(kNumEntries - 1),
+            compact.GetEntryText(*a.entry()));
+  auto current = a.CurrentEntry();
+  EXPECT_EQ(1, current.remaining());
+  EXPECT_FALSE(current.Next());
+  EXPECT_FALSE(a.Skip(1));
+}
@@ -0,0 +1,45 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#ifndef RIME_TEST_HELPERS_H_
+#define RIME_TEST_HELPERS_H_
+
+#include <gtest/gtest.h>
+#include <rime_api.h>
+#include <rime/common.h>
+#include <rime/dict/dictionary.h>
+#include <rime/dict/dict_compiler.h>
+
+namespace rime {
+
+// builds dictionary_test, which the test schemas translate with.
+inline void CompileTestDictionary() {
+  Dictionary dict("dictionary_test", {},
+                  {New<Table>(path{"dictionary_test.table.bin"})},
+                  New<Prism>(path{"dictionary_test.prism.bin"}));
+  DictCompiler dict_compiler(&dict);
+  dict_compiler.Compile(path());  // no schema file
+}
+
+// fixture for tests driving sessions through the api.
+class RimeSessionTestBase : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    CompileTestDictionary();
+    rime_ = rime_get_api();
+  }
+
+  RimeSessionId CreateSession(const char* schema_id = "concurrency_test") {
+    RimeSessionId session_id = rime_->create_session();
+    EXPECT_TRUE(rime_->select_schema(session_id, schema_id));
+    return session_id;
+  }
+
+  RimeApi* rime_ = nullptr;
+};
+
+}  // namespace rime
+
+#endif  // RIME_TEST_HELPERS_H_
@@ -0,0 +1,143 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+
+#include <gtest/gtest.h>
+#include <rime_api.h>
+#include <rime/candidate.h>
+#include <rime/common.h>
+#include <rime/context.h>
+#include <rime/menu.h>
+#include <rime/segmentation.h>
+#include <rime/service.h>
+#include <rime/translation_cache.h>
+
+#include "test_helpers.h"
+
+using namespace rime;
+
+static TranslationCacheKey MakeKey(const string& input) {
+  TranslationCacheKey key;
+  key.input = input;
+  key.tags.insert("abc");
+  key.options["ascii_mode"] = false;
+  return key;
+}
+
+static Segment MakeSegment(const string& prompt) {
+  Segment segment(0, 4);
+  segment.menu = New<Menu>();
+  segment.prompt = prompt;
+  return segment;
+}
+
+TEST(RimeTranslationCacheTest, HitAndMiss) {
+  TranslationCache cache;
+  Segment segment;
+  EXPECT_FALSE(cache.Find(MakeKey("nihao"), &segment));
+  Segment translated = MakeSegment("~");
+  cache.Insert(MakeKey("nihao"), translated);
+  EXPECT_EQ(translated.menu, cache.Find(MakeKey("nihao"), &segment));
+  EXPECT_EQ("~", segment.prompt);
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+}
+
+TEST(RimeTranslationCacheTest, KeyMatchesAllFields) {
+  TranslationCache cache;
+  cache.Insert(MakeKey("nihao"), MakeSegment(""));
+  Segment segment;
+  auto key = MakeKey("nihao");
+  key.options["ascii_mode"] = true;
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.tags.insert("punct");
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.preceding_text = "text";
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.start = 1;
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.at_end = true;
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.caret = 2;
+  EXPECT_FALSE(cache.Find(key, &segment));
+  key = MakeKey("nihao");
+  key.generation = 1;
+  EXPECT_FALSE(cache.Find(key, &segment));
+  EXPECT_TRUE(cache.Find(MakeKey("nihao"), &segment));
+}
+
+TEST(RimeTranslationCacheTest, EvictsLeastRecentlyUsed) {
+  TranslationCache cache(2);
+  cache.Insert(MakeKey("a"), MakeSegment(""));
+  cache.Insert(MakeKey("b"), MakeSegment(""));
+  Segment segment;
+  EXPECT_TRUE(cache.Find(MakeKey("a"), &segment));
+  cache.Insert(MakeKey("c"), MakeSegment(""));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_FALSE(cache.Find(MakeKey("b"), &segment));
+  EXPECT_TRUE(cache.Find(MakeKey("a"), &segment));
+  EXPECT_TRUE(cache.Find(MakeKey("c"), &segment));
+  cache.set_capacity(1);
+  EXPECT_EQ(1, cache.size());
+  EXPECT_TRUE(cache.Find(MakeKey("c"), &segment));
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+}
+
+class RimeTranslationCacheEngineTest : public RimeSessionTestBase {
+ protected:
+  void SetUp() override {
+    RimeSessionTestBase::SetUp();
+    session_id_ = CreateSession();
+  }
+
+  void TearDown() override { rime_->destroy_session(session_id_); }
+
+  Context* context() {
+    return Service::instance().GetSession(session_id_)->context();
+  }
+
+  string SelectedCandidateType() {
+    auto cand =
+        Candidate::GetGenuineCandidate(context()->GetSelectedCandidate());
+    return cand ? cand->type() : string();
+  }
+
+  RimeSessionId session_id_ = 0;
+};
+
+TEST_F(RimeTranslationCacheEngineTest, DeletedUserPhraseLeavesMenu) {
+  // learn the sentence as a user phrase
+  rime_->simulate_key_sequence(session_id_, "babai");
+  ASSERT_TRUE(rime_->commit_composition(session_id_));
+  rime_->simulate_key_sequence(session_id_, "babai");
+  ASSERT_EQ("user_phrase", SelectedCandidateType());
+  // the menu of the same segment is no longer reused
+  EXPECT_TRUE(rime_->delete_candidate(session_id_, 0));
+  EXPECT_TRUE(context()->HasMenu());
+  EXPECT_NE("user_phrase", SelectedCandidateType());
+  rime_->clear_composition(session_id_);
+}
+
+TEST_F(RimeTranslationCacheEngineTest, UserPhraseFromAnotherSession) {
+  rime_->simulate_key_sequence(session_id_, "banbei");
+  ASSERT_NE("user_phrase", SelectedCandidateType());
+  // another session learns the sentence, which is written to the shared
+  // user db once the next translation finishes the transaction.
+  RimeSessionId other = rime_->create_session();
+  ASSERT_TRUE(rime_->select_schema(other, "concurrency_test"));
+  rime_->simulate_key_sequence(other, "banbei");
+  ASSERT_TRUE(rime_->commit_composition(other));
+  rime_->simulate_key_sequence(other, "b");
+  rime_->destroy_session(other);
+  // the menu of the same segment is rebuilt
+  rime_->simulate_key_sequence(session_id_, "{BackSpace}i");
+  EXPECT_EQ("user_phrase", SelectedCandidateType());
+  rime_->clear_composition(session_id_);
+}
@@ -0,0 +1,156 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+#include <gtest/gtest.h>
+#include <rime/dict/text_db.h>
+#include <rime/dict/user_db.h>
+#include <rime/dict/user_db_cache.h>
+#include <rime/dict/user_dictionary.h>
+
+using namespace rime;
+
+class TestDb : public UserDbWrapper<TextDb>, public Transactional {
+ public:
+  TestDb() : UserDbWrapper<TextDb>(path{"user_db_cache_test.txt"},
+                                   "user_db_cache_test") {}
+
+  bool BeginTransaction() override { return in_transaction_ = true; }
+  bool AbortTransaction() override { return !(in_transaction_ = false); }
+  bool CommitTransaction() override { return !(in_transaction_ = false); }
+};
+
+static an<TestDb> OpenTestDb() {
+  auto db = New<TestDb>();
+  if (db->Exists())
+    db->Remove();
+  if (!db->Open())
+    return nullptr;
+  db->Update("ni \t你", "c=1 d=1 t=1");
+  db->Update("ni hao \t你好", "c=2 d=1 t=2");
+  db->Update("zai \t在", "c=3 d=1 t=3");
+  return db;
+}
+
+TEST(RimeUserDbCacheTest, QueryEntries) {
+  auto db = OpenTestDb();
+  ASSERT_TRUE(bool(db));
+  UserDbCache cache(db);
+  EXPECT_FALSE(cache.loaded());
+  ASSERT_TRUE(cache.Load());
+  EXPECT_EQ(3, cache.size());
+  string key, value;
+  {
+    auto accessor = cache.Query("ni ");
+    ASSERT_TRUE(bool(accessor));
+    EXPECT_TRUE(accessor->GetNextRecord(&key, &value));
+    EXPECT_EQ("ni \t你", key);
+    EXPECT_TRUE(accessor->GetNextRecord(&key, &value));
+    EXPECT_EQ("ni hao \t你好", key);
+    EXPECT_EQ("c=2 d=1 t=2", value);
+    EXPECT_TRUE(accessor->exhausted());
+    EXPECT_TRUE(accessor->Reset());
+    EXPECT_TRUE(accessor->GetNextRecord(&key, &value));
+    EXPECT_EQ("ni \t你", key);
+  }
+  {
+    auto accessor = cache.Query("");
+    EXPECT_TRUE(accessor->Jump("z"));
+    EXPECT_TRUE(accessor->GetNextRecord(&key, &value));
+    EXPECT_EQ("zai \t在", key);
+  }
+  EXPECT_TRUE(cache.Fetch("zai \t在", &value));
+  EXPECT_EQ("c=3 d=1 t=3", value);
+  EXPECT_FALSE(cache.Fetch("zai jian \t再見", &value));
+  db->Close();
+}
+
+TEST(RimeUserDbCacheTest, WriteBehind) {
+  auto db = OpenTestDb();
+  ASSERT_TRUE(bool(db));
+  UserDbCache cache(db);
+  ASSERT_TRUE(cache.Load());
+  string value;
+  EXPECT_TRUE(cache.Update("zai jian \t再見", "c=1 d=1 t=4"));
+  EXPECT_TRUE(cache.MetaUpdate("/tick", "4"));
+  EXPECT_TRUE(cache.Fetch("zai jian \t再見", &value));
+  EXPECT_EQ("c=1 d=1 t=4", value);
+  EXPECT_TRUE(cache.MetaFetch("/tick", &value));
+  EXPECT_EQ("4", value);
+  EXPECT_EQ(4, cache.size());
+  // written to the db on flush
+#ifndef RIME_NO_THREADING
+  EXPECT_FALSE(db->Fetch("zai jian \t再見", &value));
+#endif
+  EXPECT_TRUE(cache.Flush());
+  EXPECT_TRUE(db->Fetch("zai jian \t再見", &value));
+  EXPECT_EQ("c=1 d=1 t=4", value);
+  EXPECT_TRUE(db->MetaFetch("/tick", &value));
+  EXPECT_EQ("4", value);
+  EXPECT_FALSE(db->in_transaction());
+  db->Close();
+}
+
+TEST(RimeUserDbCacheTest, CommitUpdates) {
+  auto db = OpenTestDb();
+  ASSERT_TRUE(bool(db));
+  UserDbCache cache(db);
+  string value;
+  // written through before the cache is loaded
+  EXPECT_TRUE(cache.Update("ni \t你", "c=4 d=1 t=4"));
+  EXPECT_TRUE(db->Fetch("ni \t你", &value));
+  EXPECT_EQ("c=4 d=1 t=4", value);
+  EXPECT_FALSE(db->in_transaction());
+  ASSERT_TRUE(cache.Load());
+  UserDbUpdates updates;
+  updates.entries["ni \t你"] = "c=5 d=1 t=5";
+  updates.metadata["/tick"] = "5";
+  EXPECT_TRUE(cache.Commit(std::move(updates)));
+  EXPECT_TRUE(cache.Fetch("ni \t你", &value));
+  EXPECT_EQ("c=5 d=1 t=5", value);
+  EXPECT_TRUE(cache.MetaFetch("/tick", &value));
+  EXPECT_EQ("5", value);
+  EXPECT_TRUE(cache.Flush());
+  EXPECT_TRUE(db->Fetch("ni \t你", &value));
+  EXPECT_EQ("c=5 d=1 t=5", value);
+  db->Close();
+}
+
+TEST(RimeUserDbCacheTest, TransactionsOfUserDictionaries) {
+  auto db = OpenTestDb();
+  ASSERT_TRUE(bool(db));
+  auto cache = New<UserDbCache>(db);
+  string value;
+  {
+    // as in two sessions
+    UserDictionary a("user_db_cache_test", db, cache);
+    UserDictionary b("user_db_cache_test", db, cache);
+    ASSERT_TRUE(a.Load());
+    ASSERT_TRUE(b.Load());
+    ASSERT_TRUE(cache->loaded());
+    DictEntry ni;
+    ni.text = "你";
+    ni.custom_code = "ni ";
+    DictEntry zai;
+    zai.text = "在";
+    zai.custom_code = "zai ";
+    EXPECT_TRUE(a.NewTransaction());
+    EXPECT_TRUE(a.UpdateEntry(ni, 1));
+    EXPECT_TRUE(b.NewTransaction());
+    EXPECT_TRUE(b.UpdateEntry(zai, 1));
+    // not visible to others until committed
+    EXPECT_TRUE(cache->Fetch("zai \t在", &value));
+    EXPECT_EQ("c=3 d=1 t=3", value);
+    // reverting the transaction of one leaves the other's alone
+    EXPECT_TRUE(a.RevertRecentTransaction());
+    EXPECT_TRUE(b.CommitPendingTransaction());
+    EXPECT_TRUE(cache->Fetch("ni \t你", &value));
+    EXPECT_EQ("c=1 d=1 t=1", value);
+    EXPECT_TRUE(cache->Fetch("zai \t在", &value));
+    EXPECT_EQ(4, UserDbValue(value).commits);
+  }
+  EXPECT_TRUE(db->Fetch("zai \t在", &value));
+  EXPECT_EQ(4, UserDbValue(value).commits);
+  EXPECT_FALSE(db->in_transaction());
+  db->Close();
+}
@@ -4,6 +4,7 @@
 //
 // 2011-07-03 GONG Chen <chen.sst@gmail.com>
 //
+#include <fstream>
 #include <gtest/gtest.h>
 #include <rime/algo/syllabifier.h>
 #include <rime/dict/text_db.h>
@@ -89,3 +90,146 @@ TEST(RimeUserDbTest, Query) {
   }
   db.Close();
 }
+
+TEST(RimeUserDbTest, PackValue) {
+  UserDbValue v;
+  v.commits = -3;
+  v.dee = 0.84;
+  v.tick = 1234567890123;
+  string packed = v.Pack();
+  EXPECT_TRUE(UserDbValue::IsPacked(packed));
+  UserDbValue u(packed);
+  EXPECT_EQ(v.commits, u.commits);
+  EXPECT_EQ(v.dee, u.dee);
+  EXPECT_EQ(v.tick, u.tick);
+  EXPECT_FALSE(u.Unpack(packed.substr(0, packed.length() - 1)));
+}
+
+TEST(RimeUserDbTest, UnpackLegacyTextValue) {
+  EXPECT_FALSE(UserDbValue::IsPacked("c=3 d=0.84 t=1234"));
+  UserDbValue v("c=3 d=0.84 t=1234");
+  EXPECT_EQ(3, v.commits);
+  EXPECT_EQ(0.84, v.dee);
+  EXPECT_EQ(1234, v.tick);
+  EXPECT_EQ("c=3 d=0.84 t=1234", v.PackText());
+  UserDbValue empty("");
+  EXPECT_EQ(0, empty.commits);
+  EXPECT_EQ(0, empty.tick);
+}
+
+TEST(RimeUserDbTest, SaveTextValues) {
+  TestDb db(path{"user_db_test.txt"}, "user_db_test");
+  if (db.Exists())
+    db.Remove();
+  ASSERT_TRUE(db.Open());
+  UserDbValue v("c=2 d=1.5 t=7");
+  EXPECT_TRUE(db.Update("ni hao \tnihao", v.Pack()));
+  EXPECT_TRUE(db.Update("zai jian \tzaijian", "c=1 d=0.5 t=3"));
+  EXPECT_TRUE(db.Close());
+  // binary values are written to the text file as text records
+  ASSERT_TRUE(db.OpenReadOnly());
+  string value;
+  EXPECT_TRUE(db.Fetch("ni hao \tnihao", &value));
+  EXPECT_EQ("c=2 d=1.5 t=7", value);
+  EXPECT_TRUE(db.Fetch("zai jian \tzaijian", &value));
+  EXPECT_EQ("c=1 d=0.5 t=3", value);
+  db.Close();
+}
+
+static void WriteSnapshot(const path& file_path,
+                          const string& db_name,
+                          const string& tick,
+                          const vector<string>& entries) {
+  std::ofstream out(file_path.c_str());
+  out << "# Rime user dictionary" << std::endl
+      << "#@/db_name\t" << db_name << std::endl
+      << "#@/db_type\tuserdb" << std::endl
+      << "#@/tick\t" << tick << std::endl;
+  for (const auto& entry : entries) {
+    out << entry << std::endl;
+  }
+}
+
+static void OpenMergeTestDb(TestDb* db) {
+  if (db->Exists())
+    db->Remove();
+  ASSERT_TRUE(db->Open());
+  EXPECT_TRUE(db->MetaUpdate("/tick", "6"));
+  EXPECT_TRUE(db->Update("ni hao \tnihao", "c=3 d=2.5 t=5"));
+  EXPECT_TRUE(db->Update("xie xie \txiexie", "c=1 d=1.0 t=2"));
+}
+
+TEST(RimeUserDbTest, MergeSnapshotsInOnePass) {
+  const string db_name = "user_db_merge_test";
+  WriteSnapshot(path{"user_db_merge_test.a.txt"}, db_name, "10",
+                {"ni hao \tnihao\tc=2 d=1.5 t=8",
+                 "zai jian \tzaijian\tc=1 d=0.5 t=10"});
+  WriteSnapshot(path{"user_db_merge_test.b.txt"}, db_name, "4",
+                {"ni hao \tnihao\tc=5 d=3.0 t=4",
+                 "xie xie \txiexie\tc=-1 d=0.2 t=3",
+                 "zai jian \tzaijian\tc=2 d=0.8 t=2"});
+  const vector<path> snapshots = {path{"user_db_merge_test.a.txt"},
+                                  path{"user_db_merge_test.b.txt"}};
+  // merged one after another
+  TestDb expected(path{"user_db_merge_test.expected.txt"}, db_name);
+  OpenMergeTestDb(&expected);
+  for (const auto& snapshot : snapshots) {
+    TestDb temp(path{"user_db_merge_test.temp.userdb.txt"}, db_name);
+    if (temp.Exists())
+      temp.Remove();
+    ASSERT_TRUE(temp.Open());
+    ASSERT_TRUE(temp.Restore(snapshot));
+    DbSource source(&temp);
+    UserDbMerger merger(&expected);
+    source >> merger;
+    temp.Close();
+    temp.Remove();
+  }
+  // merged in one pass
+  TestDb db(path{"user_db_merge_test.txt"}, db_name);
+  OpenMergeTestDb(&db);
+  UserDbSnapshotMerger merger(&db);
+  for (const auto& snapshot : snapshots) {
+    EXPECT_TRUE(merger.AddSnapshot(snapshot));
+  }
+  int last_merged = 0;
+  EXPECT_EQ(5, merger.Merge([&](int merged, int total) {
+    EXPECT_EQ(5, total);
+    last_merged = merged;
+  }));
+  EXPECT_EQ(5, last_merged);
+
+  string tick, expected_tick;
+  EXPECT_TRUE(db.MetaFetch("/tick", &tick));
+  EXPECT_TRUE(expected.MetaFetch("/tick", &expected_tick));
+  EXPECT_EQ(expected_tick, tick);
+  for (const string key :
+       {"ni hao \tnihao", "xie xie \txiexie", "zai jian \tzaijian"}) {
+    string value, expected_value;
+    ASSERT_TRUE(db.Fetch(key, &value));
+    ASSERT_TRUE(expected.Fetch(key, &expected_value));
+    UserDbValue v(value), u(expected_value);
+    EXPECT_EQ(u.commits, v.commits) << key;
+    EXPECT_DOUBLE_EQ(u.dee, v.dee) << key;
+    EXPECT_EQ(u.tick, v.tick) << key;
+  }
+  db.Close();
+  expected.Close();
+}
+
+TEST(RimeUserDbTest, MergeSnapshotsOutOfOrder) {
+  const string db_name = "user_db_merge_test";
+  WriteSnapshot(path{"user_db_merge_test.c.txt"}, db_name, "10",
+                {"zai jian \tzaijian\tc=1 d=0.5 t=10",
+                 "ni hao \tnihao\tc=2 d=1.5 t=8"});
+  WriteSnapshot(path{"user_db_merge_test.d.txt"}, "another_db", "10",
+                {"ni hao \tnihao\tc=2 d=1.5 t=8"});
+  TestDb db(path{"user_db_merge_test.txt"}, db_name);
+  OpenMergeTestDb(&db);
+  UserDbSnapshotMerger merger(&db);
+  EXPECT_FALSE(merger.AddSnapshot(path{"user_db_merge_test.c.txt"}));
+  EXPECT_FALSE(merger.AddSnapshot(path{"user_db_merge_test.d.txt"}));
+  EXPECT_EQ(0, merger.num_snapshots());
+  EXPECT_EQ(0, merger.Merge());
+  db.Close();
+}
@@ -0,0 +1,304 @@
+//
+// Copyright RIME Developers
+// Distributed under the BSD License
+//
+// converts lines of input codes to text, without interactive sessions.
+//
+// usage:
+//   rime_batch_converter [-j <threads>] <schema_id> [translator]
+// example:
+//   rime_batch_converter -j 4 luna_pinyin < input.txt > output.txt
+//
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <rime/candidate.h>
+#include <rime/common.h>
+#include <rime/config.h>
+#include <rime/context.h>
+#include <rime/deployer.h>
+#include <rime/engine.h>
+#include <rime/schema.h>
+#include <rime/segmentation.h>
+#include <rime/setup.h>
+#include <rime/ticket.h>
+#include <rime/translation.h>
+#include <rime/translator.h>
+#include <rime/lever/deployment_tasks.h>
+#include "codepage.h"
+
+using namespace rime;
+
+// provides a translator with the schema shared by all converters, which it
+// does not own, and a context of its own. it runs no processors, segmentors
+// or translators.
+class ConversionEngine : public Engine {
+ public:
+  explicit ConversionEngine(Schema* schema) { schema_.reset(schema); }
+  ~ConversionEngine() override { schema_.release(); }
+};
+
+// converts on one thread. the schema and the dictionaries loaded by the
+// translator are shared with converters on other threads, and only read.
+class Converter {
+ public:
+  Converter(Schema* schema,
+            Translator::Component* component,
+            const string& prescription)
+      : engine_(schema) {
+    Ticket ticket(&engine_, "translator", prescription);
+    translator_.reset(component->Create(ticket));
+  }
+
+  bool ok() const { return bool(translator_); }
+
+  // makes a sentence of the whole input, continuing with what is left
+  // whenever the best candidate does not cover the rest of the input.
+  string Convert(const string& input) {
+    Context* ctx = engine_.context();
+    ctx->set_input(input);
+    string text;
+    size_t start = 0;
+    while (start < input.length()) {
+      Segment segment(start, input.length());
+      segment.tags.insert("abc");
+      auto translation = translator_->Query(input.substr(start), segment);
+      auto cand = translation ? translation->Peek() : nullptr;
+      if (!cand || cand->end() <= start) {
+        text += input.substr(start);
+        break;
+      }
+      text += cand->text();
+      start = cand->end();
+    }
+    ctx->Clear();
+    return text;
+  }
+
+ private:
+  ConversionEngine engine_;
+  the<Translator> translator_;
+};
+
+// pipes chunks of lines through a pool of converters, preserving the order
+// of output.
+class BatchConversion {
+ public:
+  static constexpr size_t kChunkSize = 256;
+
+  struct Chunk {
+    vector<string> lines;
+    bool done = false;
+  };
+
+  BatchConversion(Schema* schema,
+                  Translator::Component* component,
+                  const string& prescription,
+                  int num_threads)
+      : schema_(schema),
+        component_(component),
+        prescription_(prescription),
+        num_threads_(num_threads) {}
+
+  size_t Run(std::istream& in, std::ostream& out) {
+    vector<std::thread> workers;
+    for (int i = 0; i < num_threads_; ++i) {
+      workers.emplace_back([this] { Work(); });
+    }
+    size_t num_lines = 0;
+    string line;
+    bool eof = false;
+    while (!eof) {
+      auto chunk = New<Chunk>();
+      while (chunk->lines.size() < kChunkSize && std::getline(in, line)) {
+        chunk->lines.push_back(line);
+      }
+      eof = chunk->lines.size() < kChunkSize;
+      num_lines += chunk->lines.size();
+      std::unique_lock<std::mutex> lock(mutex_);
+      // bound the number of chunks in flight
+      Drain(lock, out, 4 * num_threads_ - 1);
+      if (failed_)
+        break;
+      pending_.push_back(chunk);
+      queue_.push_back(chunk);
+      readable_.notify_one();
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      finished_ = true;
+      readable_.notify_all();
+      Drain(lock, out, 0);
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    return failed_ ? 0 : num_lines;
+  }
+
+  bool failed() const { return failed_; }
+
+ private:
+  void Work() {
+    Converter converter(schema_, component_, prescription_);
+    if (!converter.ok()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      failed_ = true;
+      writable_.notify_all();
+      return;
+    }
+    while (true) {
+      an<Chunk> chunk;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        readable_.wait(lock, [this] { return !queue_.empty() || finished_; });
+        if (queue_.empty())
+          return;
+        chunk = queue_.front();
+        queue_.pop_front();
+      }
+      for (string& line : chunk->lines) {
+        line = converter.Convert(line);
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      chunk->done = true;
+      writable_.notify_all();
+    }
+  }
+
+  // writes out converted chunks in input order, until no more than
+  // max_pending chunks are left; called with mutex_ held.
+  void Drain(std::unique_lock<std::mutex>& lock,
+             std::ostream& out,
+             size_t max_pending) {
+    while (pending_.size() > max_pending && !failed_) {
+      writable_.wait(lock,
+                     [this] { return pending_.front()->done || failed_; });
+      while (!pending_.empty() && pending_.front()->done) {
+        auto chunk = pending_.front();
+        pending_.pop_front();
+        lock.unlock();
+        for (const string& line : chunk->lines) {
+          out << line << '\n';
+        }
+        lock.lock();
+      }
+    }
+  }
+
+  Schema* schema_;
+  Translator::Component* component_;
+  string prescription_;
+  int num_threads_;
+  std::mutex mutex_;
+  std::condition_variable readable_;
+  std::condition_variable writable_;
+  std::deque<an<Chunk>> queue_;
+  std::deque<an<Chunk>> pending_;
+  bool finished_ = false;
+  bool failed_ = false;
+};
+
+// the first script or table translator configured in the schema.
+static string FindTranslator(Schema* schema) {
+  Config* config = schema->config();
+  if (!config)
+    return string();
+  auto translators = config->GetList("engine/translators");
+  if (!translators)
+    return string();
+  for (size_t i = 0; i < translators->size(); ++i) {
+    auto prescription = As<ConfigValue>(translators->GetAt(i));
+    if (!prescription)
+      continue;
+    const string& x(prescription->str());
+    if (boost::starts_with(x, "script_translator") ||
+        boost::starts_with(x, "table_translator")) {
+      return x;
+    }
+  }
+  return string();
+}
+
+// program entry
+int main(int argc, char* argv[]) {
+  unsigned int codepage = SetConsoleOutputCodePage();
+  int num_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 2 && !strcmp(argv[1], "-j")) {
+    num_threads = std::atoi(argv[2]);
+    argc -= 2, argv += 2;
+  }
+  if (argc < 2 || argc > 3 || num_threads < 1) {
+    std::cerr << "usage: rime_batch_converter [-j <threads>] "
+                 "<schema_id> [translator]"
+              << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  string schema_id(argv[1]);
+
+  SetupLogging("rime.batch_converter");
+  LoadModules(kDefaultModules);
+
+  Deployer deployer;
+  InstallationUpdate installation;
+  if (!installation.Run(&deployer)) {
+    std::cerr << "failed to initialize installation." << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  std::cerr << "initializing...";
+  WorkspaceUpdate workspace_update;
+  if (!workspace_update.Run(&deployer)) {
+    std::cerr << "failure!" << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  // loaded once, and shared by converters on all threads
+  Schema schema(schema_id);
+  string prescription = argc > 2 ? argv[2] : FindTranslator(&schema);
+  if (prescription.empty()) {
+    std::cerr << "no translator found in schema: " << schema_id << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  Ticket ticket(nullptr, "translator", prescription);
+  auto component = Translator::Require(ticket.klass);
+  if (!component) {
+    std::cerr << "unknown translator: " << prescription << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  // user dictionaries are not to be used by threads in parallel; convert
+  // with the dictionary only, which also keeps the output independent of
+  // what has been typed.
+  if (Config* config = schema.config()) {
+    config->SetBool(ticket.name_space + "/enable_user_dict", false);
+  }
+  std::cerr << "ready." << std::endl;
+
+  std::ios::sync_with_stdio(false);
+  auto start_time = std::chrono::steady_clock::now();
+  BatchConversion conversion(&schema, component, prescription, num_threads);
+  size_t num_lines = conversion.Run(std::cin, std::cout);
+  std::cout.flush();
+  if (conversion.failed()) {
+    std::cerr << "failed to create translator: " << prescription << std::endl;
+    SetConsoleOutputCodePage(codepage);
+    return 1;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start_time;
+  std::cerr << num_lines << " lines in " << elapsed.count() << " s, "
+            << (elapsed.count() > 0 ? num_lines / elapsed.count() : 0)
+            << " lines/s (" << num_threads << " threads)." << std::endl;
+  SetConsoleOutputCodePage(codepage);
+  return 0;
+}
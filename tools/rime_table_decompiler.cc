@@ -69,10 +69,17 @@ void traversal(rime::Table* table, std::ofstream& fout) {
   auto metadata = table->metadata();
   std::cout << "num_syllables: " << metadata->num_syllables << std::endl;
   std::cout << "num_entries: " << metadata->num_entries << std::endl;
+  std::cout << "file_size: " << table->file_size() << " ("
+            << (metadata->num_entries
+                    ? double(table->file_size()) / metadata->num_entries
+                    : 0.0)
+            << " bytes per entry)" << std::endl;
+  std::cout << "packed_entries: " << (metadata->packed_entries ? "yes" : "no")
+            << std::endl;
 
   fout << std::fixed;
   fout << std::setprecision(0);
-  rime::TableQuery query(table->metadata()->index.get());
+  rime::TableQuery query = table->NewQuery();
   recursion(table, &query, fout);
 }
 